@@ -0,0 +1,225 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace matrix_view{
+
+//================================================================================================
+//=======================================scratch arena============================================
+//================================================================================================
+//bump allocator for temporaries of library operations: memory is taken from blocks, which
+//are kept after reset, so once blocks have grown to the working set, operations do not allocate
+class ScratchArena{
+public:
+    //position of arena, everything allocated after it is freed by reset(mark)
+    struct Mark{
+        size_t block;
+        size_t offset;
+    };
+
+    explicit ScratchArena(size_t blockSize_ = size_t(1) << 16);
+    //caller workspace is used as the first block, it is not owned;
+    //further blocks are allocated, if it is exhausted
+    ScratchArena(void *buffer, size_t bytes);
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena &operator=(const ScratchArena&) = delete;
+    ~ScratchArena();
+
+    void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    template <typename T>
+    T *allocate(size_t n);
+
+    Mark mark() const;
+    void reset(Mark mark);
+    void reset();
+
+    //bytes in blocks, bytes in use and blocks taken from heap
+    size_t capacity() const;
+    size_t used() const;
+    size_t heap_allocations() const;
+
+private:
+    struct block{
+        char *p;
+        size_t size;
+        bool owned;
+    };
+
+    std::vector<block> blocks;
+    size_t current = 0;
+    size_t offset = 0;
+    size_t blockSize;
+    size_t allocations = 0;
+};
+
+//arena of current thread: workspace installed by WorkspaceScope or thread-local arena
+inline ScratchArena &scratch_arena();
+
+//frees everything allocated from arena of current thread during its lifetime
+class ScratchScope{
+public:
+    ScratchScope(): arena(scratch_arena()), mark(arena.mark()) {}
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope &operator=(const ScratchScope&) = delete;
+    ~ScratchScope() { arena.reset(mark); }
+
+    template <typename T>
+    T *allocate(size_t n) { return arena.allocate<T>(n); }
+    ScratchArena &get() { return arena; }
+
+private:
+    ScratchArena &arena;
+    ScratchArena::Mark mark;
+};
+
+//library operations of current thread take temporaries from workspace during lifetime of scope;
+//threads of parallel kernels use their own arenas
+class WorkspaceScope{
+public:
+    explicit WorkspaceScope(ScratchArena &workspace);
+    WorkspaceScope(const WorkspaceScope&) = delete;
+    WorkspaceScope &operator=(const WorkspaceScope&) = delete;
+    ~WorkspaceScope();
+
+private:
+    ScratchArena *previous;
+};
+
+namespace detail{
+inline ScratchArena *&installed_workspace()
+{
+    thread_local ScratchArena *workspace = nullptr;
+    return workspace;
+}
+
+//allocator of std containers over arena, deallocation is done by reset of arena
+template <typename T>
+struct scratch_allocator{
+    using value_type = T;
+
+    scratch_allocator(): arena(&scratch_arena()) {}
+    explicit scratch_allocator(ScratchArena &arena_): arena(&arena_) {}
+    template <typename U>
+    scratch_allocator(const scratch_allocator<U> &other): arena(other.arena) {}
+
+    T *allocate(size_t n) { return arena->allocate<T>(n); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const scratch_allocator<U> &other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const scratch_allocator<U> &other) const { return arena != other.arena; }
+
+    ScratchArena *arena;
+};
+}
+
+inline ScratchArena::ScratchArena(size_t blockSize_): blockSize(blockSize_ ? blockSize_ : 1)
+{
+}
+
+inline ScratchArena::ScratchArena(void *buffer, size_t bytes): blockSize(bytes ? bytes : 1)
+{
+    if(buffer && bytes)
+        blocks.push_back({static_cast<char*>(buffer), bytes, false});
+}
+
+inline ScratchArena::~ScratchArena()
+{
+    for(auto &b: blocks)
+        if(b.owned)
+            ::operator delete(b.p);
+}
+
+inline void *ScratchArena::allocate(size_t bytes, size_t alignment)
+{
+    //the current block, then the next kept blocks, then a new block
+    for(; current < blocks.size(); ++current, offset = 0){
+        auto &b = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(b.p);
+        size_t aligned = size_t((base + offset + alignment - 1) / alignment * alignment - base);
+        if(aligned + bytes <= b.size){
+            offset = aligned + bytes;
+            return b.p + aligned;
+        }
+    }
+    size_t size = blockSize;
+    while(size < bytes + alignment)
+        size *= 2;
+    blocks.push_back({static_cast<char*>(::operator new(size)), size, true});
+    ++allocations;
+    //blocks grow, so working set fits fewer blocks after reset
+    blockSize = size * 2;
+    current = blocks.size() - 1;
+    offset = 0;
+    return allocate(bytes, alignment);
+}
+
+template <typename T>
+T *ScratchArena::allocate(size_t n)
+{
+    static_assert(std::is_trivially_destructible_v<T>, "scratch memory is not destroyed");
+    return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+}
+
+inline ScratchArena::Mark ScratchArena::mark() const
+{
+    return {current, offset};
+}
+
+inline void ScratchArena::reset(Mark mark)
+{
+    current = mark.block;
+    offset = mark.offset;
+}
+
+inline void ScratchArena::reset()
+{
+    reset({0, 0});
+}
+
+inline size_t ScratchArena::capacity() const
+{
+    size_t bytes = 0;
+    for(auto &b: blocks)
+        bytes += b.size;
+    return bytes;
+}
+
+inline size_t ScratchArena::used() const
+{
+    size_t bytes = offset;
+    for(size_t i = 0; i < current && i < blocks.size(); ++i)
+        bytes += blocks[i].size;
+    return bytes;
+}
+
+inline size_t ScratchArena::heap_allocations() const
+{
+    return allocations;
+}
+
+inline ScratchArena &scratch_arena()
+{
+    thread_local ScratchArena arena;
+    auto workspace = detail::installed_workspace();
+    return workspace ? *workspace : arena;
+}
+
+inline WorkspaceScope::WorkspaceScope(ScratchArena &workspace): previous(detail::installed_workspace())
+{
+    detail::installed_workspace() = &workspace;
+}
+
+inline WorkspaceScope::~WorkspaceScope()
+{
+    detail::installed_workspace() = previous;
+}
+
+}
+#endif // ARENA_H
@@ -0,0 +1,278 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace matrix_view {
+
+//================================================================================================
+//=========================================autotuning=============================================
+//================================================================================================
+//parameters of kernels, which are chosen by benchmarks; they are plain globals, which kernels read
+//without synchronization, so tune, autotune and apply_profile must run before other threads use the library
+struct TuneProfile{
+    detail::GemmParams gemm;
+    size_t transposeTile;
+    size_t parallelThreshold;
+};
+
+struct TuneOptions{
+    //size of square matrices in product and transpose benchmarks,
+    //Strassen crossover is tested up to it
+    size_t size = 256;
+    //the best time of repeats is taken
+    size_t repeats = 3;
+};
+
+//CPU model, cache sizes and hardware threads, profiles are stored by this key
+inline std::string cpu_key();
+//parameters, which kernels use now
+inline TuneProfile current_profile();
+inline void apply_profile(const TuneProfile &profile);
+//benchmarks candidates on running CPU, applies and returns the best ones
+inline TuneProfile tune(const TuneOptions &options = TuneOptions());
+//profile file has a line per key: key<TAB>blockRows blockInner blockColumns strassenCrossover tile threshold;
+//line with zero or too large values is not loaded
+inline bool load_profile(const std::string &path, TuneProfile &profile, const std::string &key = cpu_key());
+inline void save_profile(const std::string &path, const TuneProfile &profile, const std::string &key = cpu_key());
+//applies profile of this CPU from file, otherwise tunes and saves it; returns true, if profile is loaded
+inline bool autotune(const std::string &path, const TuneOptions &options = TuneOptions());
+
+namespace detail{
+//bounds of loaded values, zero block would make product loop forever
+inline bool valid_profile(const TuneProfile &p)
+{
+    auto within = [](size_t value, size_t low, size_t high){ return value >= low && value <= high; };
+    return within(p.gemm.blockRows, 1, 1 << 16) && within(p.gemm.blockInner, 1, 1 << 16) &&
+           within(p.gemm.blockColumns, 1, 1 << 16) && within(p.gemm.strassenCrossover, 16, 1 << 20) &&
+           within(p.transposeTile, 1, 1 << 12) && within(p.parallelThreshold, 1, size_t(1) << 40);
+}
+
+inline std::string read_line(const std::string &path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+//the best of repeats calls of func in seconds
+template <typename Function>
+double best_time(size_t repeats, Function func)
+{
+    double best = 0;
+    for(size_t r = 0; r < std::max<size_t>(1, repeats); ++r){
+        auto start = std::chrono::steady_clock::now();
+        func();
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = r == 0 ? t : std::min(best, t);
+    }
+    return best;
+}
+
+//candidate, with which benchmark(candidate) takes the least time
+template <typename Benchmark>
+size_t best_candidate(const std::vector<size_t> &candidates, Benchmark benchmark)
+{
+    size_t best = candidates.front();
+    double bestTime = 0;
+    for(size_t k = 0; k < candidates.size(); ++k){
+        double t = benchmark(candidates[k]);
+        if(k == 0 || t < bestTime){
+            best = candidates[k];
+            bestTime = t;
+        }
+    }
+    return best;
+}
+
+//block sizes are tuned one by one, each with the best ones found before it
+inline void tune_gemm(const TuneOptions &options, TuneProfile &profile)
+{
+    size_t n = options.size;
+    const auto a = make_random_matrix<double>(n, n, -1, 1, 1);
+    const auto b = make_random_matrix<double>(n, n, -1, 1, 2);
+    Matrix<double> c(n, n);
+    auto run = [&]{
+        return best_time(options.repeats, [&]{ gemm(view(a), view(b), view(c)); });
+    };
+    GemmParams &p = profile.gemm;
+    for(auto field: {&GemmParams::blockRows, &GemmParams::blockInner, &GemmParams::blockColumns}){
+        std::vector<size_t> candidates = field == &GemmParams::blockRows ? std::vector<size_t>{16, 32, 64, 128} :
+                                                                          std::vector<size_t>{64, 128, 256, 512};
+        p.*field = best_candidate(candidates, [&](size_t value){
+            gemm_params = p;
+            gemm_params.*field = value;
+            return run();
+        });
+    }
+    gemm_params = p;
+
+    //the smallest crossover c, for which one Strassen level on 2c x 2c is faster than blocked product
+    p.strassenCrossover = 0;
+    size_t largest = 32;
+    for(size_t crossover = 32; 2 * crossover <= n; crossover *= 2){
+        largest = crossover;
+        const auto x = make_random_matrix<double>(2 * crossover, 2 * crossover, -1, 1, 3);
+        Matrix<double> y(2 * crossover, 2 * crossover);
+        gemm_params.strassenCrossover = crossover;
+        double blocked = best_time(options.repeats, [&]{ gemm(view(x), view(x), view(y)); });
+        double fast = best_time(options.repeats, [&]{ strassen(view(x), view(x), view(y)); });
+        if(fast < blocked){
+            p.strassenCrossover = crossover;
+            break;
+        }
+    }
+    if(!p.strassenCrossover)
+        p.strassenCrossover = 2 * largest;
+    gemm_params = p;
+}
+
+inline void tune_transpose(const TuneOptions &options, TuneProfile &profile)
+{
+    size_t n = options.size;
+    auto square = make_random_matrix<double>(n, n, -1, 1, 4);
+    auto wide = make_random_matrix<double>(n, n + n / 2, -1, 1, 5);
+    profile.transposeTile = best_candidate({8, 16, 32, 64, 128}, [&](size_t tile){
+        transpose_params.tile = tile;
+        return best_time(options.repeats, [&]{
+            square.transpose();
+            wide.transpose();
+        });
+    });
+    transpose_params.tile = profile.transposeTile;
+}
+
+//the smallest size, which element-wise kernel runs faster on all threads than on one;
+//threshold is elements per thread at that size
+inline void tune_threshold(const TuneOptions &options, TuneProfile &profile)
+{
+    size_t threads = hardware_threads();
+    if(threads <= 1)
+        return;
+    size_t saved = parallel_threshold;
+    profile.parallelThreshold = 0;
+    for(size_t n = size_t(1) << 12; n <= (size_t(1) << 22); n *= 2){
+        auto a = make_random_matrix<double>(1, n, -1, 1, 6);
+        Matrix<double> out(1, n);
+        auto f = [](double x){ return x * x + 1; };
+        parallel_threshold = n;
+        double serial = best_time(options.repeats, [&]{ map_to(out, f, a); });
+        parallel_threshold = std::max<size_t>(1, n / threads);
+        double parallel = best_time(options.repeats, [&]{ map_to(out, f, a); });
+        if(parallel < serial){
+            profile.parallelThreshold = std::max<size_t>(1, n / threads);
+            break;
+        }
+    }
+    if(!profile.parallelThreshold)
+        profile.parallelThreshold = saved;
+    parallel_threshold = profile.parallelThreshold;
+}
+}
+
+inline std::string cpu_key()
+{
+    std::string model = "unknown";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    for(std::string line; std::getline(cpuinfo, line);){
+        if(line.compare(0, 10, "model name") == 0){
+            auto first = line.find_first_not_of(' ', line.find(':') + 1);
+            if(first != std::string::npos)
+                model = line.substr(first);
+            break;
+        }
+    }
+    std::ostringstream key;
+    key << model;
+    for(size_t index = 0;; ++index){
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::string size = detail::read_line(dir + "size");
+        if(size.empty())
+            break;
+        std::string type = detail::read_line(dir + "type");
+        key << " L" << detail::read_line(dir + "level") << (type == "Data" ? "d" : type == "Instruction" ? "i" : "")
+            << ":" << size;
+    }
+    key << " threads:" << detail::hardware_threads();
+    return key.str();
+}
+
+inline TuneProfile current_profile()
+{
+    return {detail::gemm_params, detail::transpose_params.tile, detail::parallel_threshold};
+}
+
+inline void apply_profile(const TuneProfile &profile)
+{
+    detail::gemm_params = profile.gemm;
+    detail::transpose_params.tile = profile.transposeTile;
+    detail::parallel_threshold = profile.parallelThreshold;
+}
+
+inline TuneProfile tune(const TuneOptions &options)
+{
+    TuneProfile profile = current_profile();
+    detail::tune_gemm(options, profile);
+    detail::tune_transpose(options, profile);
+    detail::tune_threshold(options, profile);
+    apply_profile(profile);
+    return profile;
+}
+
+inline bool load_profile(const std::string &path, TuneProfile &profile, const std::string &key)
+{
+    std::ifstream in(path);
+    for(std::string line; std::getline(in, line);){
+        auto tab = line.find('\t');
+        if(tab == std::string::npos || line.compare(0, tab, key) != 0 || tab != key.size())
+            continue;
+        std::istringstream values(line.substr(tab + 1));
+        TuneProfile p;
+        if(values >> p.gemm.blockRows >> p.gemm.blockInner >> p.gemm.blockColumns >> p.gemm.strassenCrossover
+                  >> p.transposeTile >> p.parallelThreshold && detail::valid_profile(p)){
+            profile = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void save_profile(const std::string &path, const TuneProfile &profile, const std::string &key)
+{
+    //profiles of other CPUs are kept
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(path);
+        for(std::string line; std::getline(in, line);)
+            if(line.compare(0, key.size() + 1, key + '\t') != 0)
+                lines.push_back(line);
+    }
+    std::ostringstream line;
+    line << key << '\t' << profile.gemm.blockRows << ' ' << profile.gemm.blockInner << ' ' << profile.gemm.blockColumns
+         << ' ' << profile.gemm.strassenCrossover << ' ' << profile.transposeTile << ' ' << profile.parallelThreshold;
+    lines.push_back(line.str());
+    std::ofstream out(path, std::ios::trunc);
+    if(!out)
+        throw std::runtime_error("cannot write profile " + path);
+    for(auto &l: lines)
+        out << l << '\n';
+}
+
+inline bool autotune(const std::string &path, const TuneOptions &options)
+{
+    TuneProfile profile;
+    if(load_profile(path, profile)){
+        apply_profile(profile);
+        return true;
+    }
+    save_profile(path, tune(options));
+    return false;
+}
+
+}
+#endif // AUTOTUNE_H
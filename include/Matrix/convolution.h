@@ -0,0 +1,270 @@
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//=====================================convolution kernels========================================
+//================================================================================================
+//kernel area (rows * columns) for automatic choice of method:
+//up to directMaxArea - direct, up to im2colMaxArea - im2col + GEMV, larger - FFT
+struct ConvParams{
+    size_t directMaxArea = 25;
+    size_t im2colMaxArea = 400;
+    //output pixels in one im2col patch matrix
+    size_t im2colChunk = 256;
+};
+
+inline ConvParams conv_params;
+
+//out(i, j) = sum kernel(u, v) * image(i + rowShift + u, j + columnShift + v), image is 0 outside
+struct conv_shape{
+    size_t rows;
+    size_t columns;
+    std::ptrdiff_t rowShift;
+    std::ptrdiff_t columnShift;
+};
+
+inline conv_shape conv_output(size_t h, size_t w, size_t kh, size_t kw, ConvMode mode)
+{
+    if(kh == 0 || kw == 0)
+        throw std::length_error("kernel is empty");
+    switch(mode){
+    case ConvMode::Full:
+        return {h + kh - 1, w + kw - 1, -std::ptrdiff_t(kh - 1), -std::ptrdiff_t(kw - 1)};
+    case ConvMode::Same:
+        return {h, w, -std::ptrdiff_t(kh / 2), -std::ptrdiff_t(kw / 2)};
+    default:
+        if(h < kh || w < kw)
+            throw std::length_error("kernel is larger than image");
+        return {h - kh + 1, w - kw + 1, 0, 0};
+    }
+}
+
+//columns [jb, je) of output row, for which image column j + shift exists
+inline bool conv_columns(std::ptrdiff_t shift, size_t w, size_t columns, size_t &jb, size_t &je)
+{
+    jb = shift < 0 ? size_t(-shift) : 0;
+    std::ptrdiff_t end = std::ptrdiff_t(w) - shift;
+    je = end > 0 ? std::min(columns, size_t(end)) : 0;
+    return jb < je;
+}
+
+//every tap of kernel adds shifted image row to output row, output rows run in parallel
+template <typename T>
+void correlate_direct(const Matrix<T>& image, const Matrix<T>& kernel, const conv_shape& s, Matrix<T>& out)
+{
+    size_t h = image.rows(), w = image.columns(), kh = kernel.rows(), kw = kernel.columns();
+    parallel_for(0, s.rows, parallel_grain(s.columns * kh * kw), [&](size_t rb, size_t re){
+        for(size_t i = rb; i < re; ++i){
+            T* o = out.data() + i * s.columns;
+            for(size_t u = 0; u < kh; ++u){
+                std::ptrdiff_t r = std::ptrdiff_t(i + u) + s.rowShift;
+                if(r < 0 || r >= std::ptrdiff_t(h))
+                    continue;
+                const T* in = image.data() + r * w;
+                const T* k = kernel.data() + u * kw;
+                for(size_t v = 0; v < kw; ++v){
+                    std::ptrdiff_t shift = std::ptrdiff_t(v) + s.columnShift;
+                    size_t jb, je;
+                    if(!conv_columns(shift, w, s.columns, jb, je))
+                        continue;
+                    T kv = k[v];
+                    //jb + shift is not negative, so src stays inside the row
+                    const T* src = in + (std::ptrdiff_t(jb) + shift);
+                    T* dst = o + jb;
+                    for(size_t j = 0; j < je - jb; ++j)
+                        dst[j] += kv * src[j];
+                }
+            }
+        }
+    });
+}
+
+//output rows are split on chunks, every chunk builds patch matrix (taps x pixels)
+//from contiguous segments of image rows and multiplies kernel^T by it
+template <typename T>
+void correlate_im2col(const Matrix<T>& image, const Matrix<T>& kernel, const conv_shape& s, Matrix<T>& out)
+{
+    size_t h = image.rows(), w = image.columns(), kh = kernel.rows(), kw = kernel.columns();
+    size_t taps = kh * kw;
+    size_t chunkRows = std::max<size_t>(1, conv_params.im2colChunk / std::max<size_t>(1, s.columns));
+    size_t chunks = (s.rows + chunkRows - 1) / chunkRows;
+    parallel_for(0, chunks, parallel_grain(chunkRows * s.columns * taps), [&](size_t cb, size_t ce){
+        std::vector<T> patch;
+        for(size_t c = cb; c < ce; ++c){
+            size_t i0 = c * chunkRows, i1 = std::min(i0 + chunkRows, s.rows);
+            size_t pixels = (i1 - i0) * s.columns;
+            patch.assign(taps * pixels, T());
+            for(size_t u = 0; u < kh; ++u){
+                for(size_t v = 0; v < kw; ++v){
+                    T* row = patch.data() + (u * kw + v) * pixels;
+                    std::ptrdiff_t shift = std::ptrdiff_t(v) + s.columnShift;
+                    size_t jb, je;
+                    if(!conv_columns(shift, w, s.columns, jb, je))
+                        continue;
+                    for(size_t i = i0; i < i1; ++i){
+                        std::ptrdiff_t r = std::ptrdiff_t(i + u) + s.rowShift;
+                        if(r < 0 || r >= std::ptrdiff_t(h))
+                            continue;
+                        const T* src = image.data() + r * std::ptrdiff_t(w) + (std::ptrdiff_t(jb) + shift);
+                        std::copy(src, src + (je - jb), row + (i - i0) * s.columns + jb);
+                    }
+                }
+            }
+            block_view<const T> p{patch.data(), taps, pixels, pixels};
+            gemv_transposed(T(1), p, kernel.data(), T(), out.data() + i0 * s.columns);
+        }
+    });
+}
+
+//---------------------------------------FFT----------------------------------------------------
+using complex = std::complex<double>;
+
+inline size_t next_power_of_two(size_t n)
+{
+    size_t p = 1;
+    while(p < n)
+        p <<= 1;
+    return p;
+}
+
+//in-place iterative radix-2 FFT, n is power of two, twiddles[k] = exp(-2 pi i k / n)
+inline void fft(complex* a, size_t n, const std::vector<complex>& twiddles, bool inverse)
+{
+    for(size_t i = 1, j = 0; i < n; ++i){
+        size_t bit = n >> 1;
+        for(; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if(i < j)
+            std::swap(a[i], a[j]);
+    }
+    for(size_t len = 2; len <= n; len <<= 1){
+        size_t step = n / len;
+        for(size_t i = 0; i < n; i += len){
+            for(size_t k = 0; k < len / 2; ++k){
+                complex w = inverse ? std::conj(twiddles[k * step]) : twiddles[k * step];
+                complex x = a[i + k], y = a[i + k + len / 2] * w;
+                a[i + k] = x + y;
+                a[i + k + len / 2] = x - y;
+            }
+        }
+    }
+}
+
+inline std::vector<complex> fft_twiddles(size_t n)
+{
+    std::vector<complex> twiddles(n / 2 + 1);
+    for(size_t k = 0; k < twiddles.size(); ++k)
+        twiddles[k] = std::polar(1.0, -6.283185307179586477 * double(k) / double(n));
+    return twiddles;
+}
+
+//FFT of rows, then of columns, rows and columns run in parallel
+inline void fft2d(std::vector<complex>& a, size_t rows, size_t columns, bool inverse)
+{
+    auto rowTwiddles = fft_twiddles(columns);
+    auto columnTwiddles = fft_twiddles(rows);
+    parallel_for(0, rows, parallel_grain(columns * 8), [&](size_t rb, size_t re){
+        for(size_t i = rb; i < re; ++i)
+            fft(a.data() + i * columns, columns, rowTwiddles, inverse);
+    });
+    parallel_for(0, columns, parallel_grain(rows * 8), [&](size_t cb, size_t ce){
+        std::vector<complex> column(rows);
+        for(size_t j = cb; j < ce; ++j){
+            for(size_t i = 0; i < rows; ++i)
+                column[i] = a[i * columns + j];
+            fft(column.data(), rows, columnTwiddles, inverse);
+            for(size_t i = 0; i < rows; ++i)
+                a[i * columns + j] = column[i];
+        }
+    });
+}
+
+//correlation is convolution with flipped kernel: product of spectra of padded image and kernel
+template <typename T>
+void correlate_fft(const Matrix<T>& image, const Matrix<T>& kernel, const conv_shape& s, Matrix<T>& out)
+{
+    size_t h = image.rows(), w = image.columns(), kh = kernel.rows(), kw = kernel.columns();
+    size_t rows = next_power_of_two(h + kh - 1), columns = next_power_of_two(w + kw - 1);
+    std::vector<complex> a(rows * columns), b(rows * columns);
+    for(size_t i = 0; i < h; ++i)
+        for(size_t j = 0; j < w; ++j)
+            a[i * columns + j] = double(image.data()[i * w + j]);
+    for(size_t u = 0; u < kh; ++u)
+        for(size_t v = 0; v < kw; ++v)
+            b[(kh - 1 - u) * columns + (kw - 1 - v)] = double(kernel.data()[u * kw + v]);
+    fft2d(a, rows, columns, false);
+    fft2d(b, rows, columns, false);
+    for(size_t i = 0; i < a.size(); ++i)
+        a[i] *= b[i];
+    fft2d(a, rows, columns, true);
+
+    double scale = 1.0 / double(rows * columns);
+    size_t r0 = size_t(s.rowShift + std::ptrdiff_t(kh - 1));
+    size_t c0 = size_t(s.columnShift + std::ptrdiff_t(kw - 1));
+    for(size_t i = 0; i < s.rows; ++i){
+        for(size_t j = 0; j < s.columns; ++j){
+            double value = a[(i + r0) * columns + j + c0].real() * scale;
+            if constexpr(std::is_integral_v<T>)
+                out.data()[i * s.columns + j] = static_cast<T>(std::llround(value));
+            else
+                out.data()[i * s.columns + j] = static_cast<T>(value);
+        }
+    }
+}
+
+template <typename T>
+Matrix<T> correlate(const Matrix<T>& image, const Matrix<T>& kernel, ConvMode mode, ConvMethod method)
+{
+    auto s = conv_output(image.rows(), image.columns(), kernel.rows(), kernel.columns(), mode);
+    Matrix<T> out(s.rows, s.columns);
+    if(s.rows == 0 || s.columns == 0)
+        return out;
+    size_t area = kernel.rows() * kernel.columns();
+    if(method == ConvMethod::Auto)
+        method = area <= conv_params.directMaxArea ? ConvMethod::Direct :
+                 area <= conv_params.im2colMaxArea ? ConvMethod::Im2col : ConvMethod::FFT;
+    switch(method){
+    case ConvMethod::Direct:
+        correlate_direct(image, kernel, s, out);
+        break;
+    case ConvMethod::Im2col:
+        correlate_im2col(image, kernel, s, out);
+        break;
+    default:
+        correlate_fft(image, kernel, s, out);
+    }
+    return out;
+}
+}
+
+//================================================================================================
+//=======================================convolution==============================================
+//================================================================================================
+template <typename T>
+Matrix<type_is_t<T>> correlate2d(const Matrix<T>& image, const Matrix<T>& kernel,
+                                 ConvMode mode, ConvMethod method)
+{
+    return detail::correlate(detail::dense(image), detail::dense(kernel), mode, method);
+}
+
+template <typename T>
+Matrix<type_is_t<T>> conv2d(const Matrix<T>& image, const Matrix<T>& kernel,
+                            ConvMode mode, ConvMethod method)
+{
+    const auto& k = detail::dense(kernel);
+    Matrix<type_is_t<T>> flipped(k.rows(), k.columns());
+    std::reverse_copy(k.begin(), k.end(), flipped.begin());
+    return detail::correlate(detail::dense(image), flipped, mode, method);
+}
+
+}
+#endif // CONVOLUTION_H
@@ -0,0 +1,507 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace matrix_view {
+
+//point-to-point channel between cooperating processes, messages between two ranks keep their order
+class Transport{
+public:
+    virtual ~Transport() = default;
+
+    virtual size_t rank() const = 0;
+    virtual size_t size() const = 0;
+    virtual void send(size_t dest, const void *data, size_t bytes) = 0;
+    virtual void recv(size_t src, void *data, size_t bytes) = 0;
+};
+
+//full mesh of Unix domain sockets, rank r listens on dir/rank_r.sock
+class UnixSocketTransport: public Transport{
+public:
+    UnixSocketTransport(size_t rank_, size_t size_, const std::string &dir);
+    UnixSocketTransport(const UnixSocketTransport &other) = delete;
+    UnixSocketTransport &operator=(const UnixSocketTransport &other) = delete;
+    ~UnixSocketTransport() override;
+
+    size_t rank() const override;
+    size_t size() const override;
+    void send(size_t dest, const void *data, size_t bytes) override;
+    void recv(size_t src, void *data, size_t bytes) override;
+
+private:
+    static std::string socket_path(const std::string &dir, size_t rank);
+
+    size_t myRank;
+    size_t amountRanks;
+    std::string listenPath;
+    int listenFd = -1;
+    std::vector<int> peers;
+};
+
+//fork size - 1 processes, process of rank r calls func(transport of rank r),
+//the calling process is rank 0, throws if any process failed
+template <typename Function>
+void run_local_cluster(size_t size, const std::string &dir, Function func);
+
+//matrix split on block x block blocks, block (I, J) is owned by process (I mod Pr, J mod Pc)
+//of Pr x Pc grid of processes (block-cyclic distribution)
+template <typename T>
+class ShardedMatrix{
+public:
+    ShardedMatrix(Transport &transport_, size_t amountRows_, size_t amountColumns_, size_t block_ = 256);
+
+    //matrix of rank 0 is distributed to all processes
+    static ShardedMatrix scatter(Transport &transport, const Matrix<T> &matrix,
+                                 size_t rows, size_t columns, size_t block = 256);
+    //full matrix on rank 0, empty matrix on other ranks
+    Matrix<T> gather() const;
+
+    size_t rows() const;
+    size_t columns() const;
+    size_t block_size() const;
+    size_t grid_rows() const;
+    size_t grid_columns() const;
+
+    //block (I, J) must be owned by this process
+    bool owns(size_t bi, size_t bj) const;
+    Matrix<T> &local_block(size_t bi, size_t bj);
+    const Matrix<T> &local_block(size_t bi, size_t bj) const;
+
+private:
+    size_t block_rows(size_t bi) const;
+    size_t block_columns(size_t bj) const;
+    size_t block_count_rows() const;
+    size_t block_count_columns() const;
+    size_t local_count_rows() const;
+    size_t local_count_columns() const;
+    size_t owner(size_t bi, size_t bj) const;
+
+    Transport &transport;
+    size_t amountRows;
+    size_t amountColumns;
+    size_t block;
+    size_t gridRows;
+    size_t gridColumns;
+    size_t myRow;
+    size_t myColumn;
+    std::vector<Matrix<T>> blocks;
+
+    template <typename Tp>
+    friend ShardedMatrix<Tp> dot(const ShardedMatrix<Tp> &a, const ShardedMatrix<Tp> &b);
+};
+
+//SUMMA: for every block column K of A row owners broadcast A(:, K) along rows of grid,
+//column owners broadcast B(K, :) along columns of grid, every process updates its blocks of C
+template <typename T>
+ShardedMatrix<T> dot(const ShardedMatrix<T> &a, const ShardedMatrix<T> &b);
+
+//================================================================================================
+//===================================UnixSocketTransport==========================================
+//================================================================================================
+inline std::string UnixSocketTransport::socket_path(const std::string &dir, size_t rank)
+{
+    return dir + "/rank_" + std::to_string(rank) + ".sock";
+}
+
+inline UnixSocketTransport::UnixSocketTransport(size_t rank_, size_t size_, const std::string &dir):
+    myRank(rank_), amountRanks(size_), listenPath(socket_path(dir, rank_)), peers(size_, -1)
+{
+    if(myRank >= amountRanks)
+        throw std::logic_error("wrong rank");
+    auto address = [](const std::string &path){
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if(path.size() >= sizeof(addr.sun_path))
+            throw std::runtime_error("socket path is too long " + path);
+        std::strcpy(addr.sun_path, path.c_str());
+        return addr;
+    };
+
+    auto addr = address(listenPath);
+    ::unlink(listenPath.c_str());
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+       ::listen(listenFd, int(amountRanks)) != 0)
+        throw std::runtime_error("cannot listen " + listenPath);
+
+    //connect to lower ranks (they may be not started yet), accept higher ranks
+    for(size_t r = 0; r < myRank; ++r){
+        auto peer = address(socket_path(dir, r));
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while(::connect(fd, reinterpret_cast<sockaddr*>(&peer), sizeof(peer)) != 0){
+            if(std::chrono::steady_clock::now() > deadline)
+                throw std::runtime_error("cannot connect to rank " + std::to_string(r));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        peers[r] = fd;
+        uint64_t id = myRank;
+        send(r, &id, sizeof(id));
+    }
+    for(size_t i = myRank + 1; i < amountRanks; ++i){
+        int fd = ::accept(listenFd, nullptr, nullptr);
+        if(fd < 0)
+            throw std::runtime_error("cannot accept connection");
+        uint64_t id = 0;
+        for(size_t done = 0; done < sizeof(id);){
+            auto n = ::recv(fd, reinterpret_cast<char*>(&id) + done, sizeof(id) - done, 0);
+            if(n <= 0)
+                throw std::runtime_error("cannot receive rank");
+            done += size_t(n);
+        }
+        if(id >= amountRanks || peers[id] != -1)
+            throw std::runtime_error("wrong rank of peer");
+        peers[id] = fd;
+    }
+}
+
+inline UnixSocketTransport::~UnixSocketTransport()
+{
+    for(int fd: peers)
+        if(fd >= 0)
+            ::close(fd);
+    if(listenFd >= 0)
+        ::close(listenFd);
+    ::unlink(listenPath.c_str());
+}
+
+inline size_t UnixSocketTransport::rank() const
+{
+    return myRank;
+}
+
+inline size_t UnixSocketTransport::size() const
+{
+    return amountRanks;
+}
+
+inline void UnixSocketTransport::send(size_t dest, const void *data, size_t bytes)
+{
+    const char *p = static_cast<const char*>(data);
+    for(size_t done = 0; done < bytes;){
+        auto n = ::send(peers.at(dest), p + done, bytes - done, MSG_NOSIGNAL);
+        if(n <= 0)
+            throw std::runtime_error("cannot send to rank " + std::to_string(dest));
+        done += size_t(n);
+    }
+}
+
+inline void UnixSocketTransport::recv(size_t src, void *data, size_t bytes)
+{
+    char *p = static_cast<char*>(data);
+    for(size_t done = 0; done < bytes;){
+        auto n = ::recv(peers.at(src), p + done, bytes - done, 0);
+        if(n <= 0)
+            throw std::runtime_error("cannot receive from rank " + std::to_string(src));
+        done += size_t(n);
+    }
+}
+
+template <typename Function>
+void run_local_cluster(size_t size, const std::string &dir, Function func)
+{
+    std::vector<pid_t> children;
+    for(size_t r = 1; r < size; ++r){
+        pid_t pid = ::fork();
+        if(pid < 0)
+            throw std::runtime_error("cannot fork");
+        if(pid == 0){
+            int status = 0;
+            try{
+                UnixSocketTransport transport(r, size, dir);
+                func(transport);
+            }
+            catch(...){
+                status = 1;
+            }
+            ::_exit(status);
+        }
+        children.push_back(pid);
+    }
+
+    std::exception_ptr error;
+    try{
+        UnixSocketTransport transport(0, size, dir);
+        func(transport);
+    }
+    catch(...){
+        error = std::current_exception();
+    }
+    bool failed = false;
+    for(auto pid: children){
+        int status = 0;
+        ::waitpid(pid, &status, 0);
+        failed = failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    if(error)
+        std::rethrow_exception(error);
+    if(failed)
+        throw std::runtime_error("worker process failed");
+}
+
+//================================================================================================
+//======================================ShardedMatrix=============================================
+//================================================================================================
+namespace detail{
+//rows of Pr x Pc grid, Pr is the largest divisor of size not greater than sqrt(size)
+inline size_t grid_rows(size_t size)
+{
+    size_t rows = 1;
+    for(size_t r = 1; r * r <= size; ++r)
+        if(size % r == 0)
+            rows = r;
+    return rows;
+}
+
+//linear broadcast of buffer from root to group of ranks
+template <typename T>
+void broadcast(Transport &transport, size_t root, const std::vector<size_t> &group, std::vector<T> &buffer)
+{
+    if(transport.rank() == root){
+        for(auto r: group)
+            if(r != root)
+                transport.send(r, buffer.data(), buffer.size() * sizeof(T));
+    }
+    else
+        transport.recv(root, buffer.data(), buffer.size() * sizeof(T));
+}
+}
+
+template <typename T>
+ShardedMatrix<T>::ShardedMatrix(Transport &transport_, size_t amountRows_, size_t amountColumns_, size_t block_):
+    transport(transport_), amountRows(amountRows_), amountColumns(amountColumns_), block(block_),
+    gridRows(detail::grid_rows(transport_.size())), gridColumns(transport_.size() / gridRows),
+    myRow(transport_.rank() / gridColumns), myColumn(transport_.rank() % gridColumns)
+{
+    if(block == 0)
+        throw std::logic_error("block size must be positive");
+    for(size_t li = 0; li < local_count_rows(); ++li)
+        for(size_t lj = 0; lj < local_count_columns(); ++lj)
+            blocks.emplace_back(block_rows(li * gridRows + myRow), block_columns(lj * gridColumns + myColumn));
+}
+
+template <typename T>
+ShardedMatrix<T> ShardedMatrix<T>::scatter(Transport &transport, const Matrix<T> &matrix,
+                                           size_t rows, size_t columns, size_t block)
+{
+    ShardedMatrix<T> res(transport, rows, columns, block);
+    if(transport.rank() == 0 && (matrix.rows() != rows || matrix.columns() != columns))
+        throw std::runtime_error("Matrix dimensions must agree");
+    for(size_t bi = 0; bi < res.block_count_rows(); ++bi){
+        for(size_t bj = 0; bj < res.block_count_columns(); ++bj){
+            size_t owner = res.owner(bi, bj);
+            if(transport.rank() == 0){
+                Matrix<T> blockMatrix(res.block_rows(bi), res.block_columns(bj));
+                for(size_t i = 0; i < blockMatrix.rows(); ++i){
+                    auto row = matrix.begin_row(bi * block + i) + bj * block;
+                    std::copy(row, row + blockMatrix.columns(), blockMatrix.begin_row(i));
+                }
+                if(owner == 0)
+                    res.local_block(bi, bj) = blockMatrix;
+                else
+                    transport.send(owner, blockMatrix.data(), blockMatrix.rows() * blockMatrix.columns() * sizeof(T));
+            }
+            else if(owner == transport.rank()){
+                auto &local = res.local_block(bi, bj);
+                transport.recv(0, local.data(), local.rows() * local.columns() * sizeof(T));
+            }
+        }
+    }
+    return res;
+}
+
+template <typename T>
+Matrix<T> ShardedMatrix<T>::gather() const
+{
+    if(transport.rank() != 0){
+        for(auto &local: blocks)
+            transport.send(0, local.data(), local.rows() * local.columns() * sizeof(T));
+        return Matrix<T>();
+    }
+    Matrix<T> res(amountRows, amountColumns);
+    for(size_t bi = 0; bi < block_count_rows(); ++bi){
+        for(size_t bj = 0; bj < block_count_columns(); ++bj){
+            Matrix<T> blockMatrix(block_rows(bi), block_columns(bj));
+            size_t owner = this->owner(bi, bj);
+            if(owner == 0)
+                blockMatrix = local_block(bi, bj);
+            else
+                transport.recv(owner, blockMatrix.data(), blockMatrix.rows() * blockMatrix.columns() * sizeof(T));
+            for(size_t i = 0; i < blockMatrix.rows(); ++i)
+                std::copy(blockMatrix.begin_row(i), blockMatrix.end_row(i),
+                          res.begin_row(bi * block + i) + bj * block);
+        }
+    }
+    return res;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::rows() const
+{
+    return amountRows;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::columns() const
+{
+    return amountColumns;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::block_size() const
+{
+    return block;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::grid_rows() const
+{
+    return gridRows;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::grid_columns() const
+{
+    return gridColumns;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::block_rows(size_t bi) const
+{
+    return std::min(block, amountRows - bi * block);
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::block_columns(size_t bj) const
+{
+    return std::min(block, amountColumns - bj * block);
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::block_count_rows() const
+{
+    return (amountRows + block - 1) / block;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::block_count_columns() const
+{
+    return (amountColumns + block - 1) / block;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::local_count_rows() const
+{
+    size_t count = block_count_rows();
+    return count > myRow ? (count - myRow + gridRows - 1) / gridRows : 0;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::local_count_columns() const
+{
+    size_t count = block_count_columns();
+    return count > myColumn ? (count - myColumn + gridColumns - 1) / gridColumns : 0;
+}
+
+template <typename T>
+size_t ShardedMatrix<T>::owner(size_t bi, size_t bj) const
+{
+    return (bi % gridRows) * gridColumns + bj % gridColumns;
+}
+
+template <typename T>
+bool ShardedMatrix<T>::owns(size_t bi, size_t bj) const
+{
+    return bi < block_count_rows() && bj < block_count_columns() && owner(bi, bj) == transport.rank();
+}
+
+template <typename T>
+Matrix<T> &ShardedMatrix<T>::local_block(size_t bi, size_t bj)
+{
+    return const_cast<Matrix<T>&>(static_cast<const ShardedMatrix<T>&>(*this).local_block(bi, bj));
+}
+
+template <typename T>
+const Matrix<T> &ShardedMatrix<T>::local_block(size_t bi, size_t bj) const
+{
+    if(!owns(bi, bj))
+        throw std::out_of_range("block is not owned by this process");
+    return blocks[(bi / gridRows) * local_count_columns() + bj / gridColumns];
+}
+
+template <typename T>
+ShardedMatrix<T> dot(const ShardedMatrix<T> &a, const ShardedMatrix<T> &b)
+{
+    if(a.columns() != b.rows())
+        throw std::length_error("Inner matrix dimensions must agree");
+    if(a.block != b.block || &a.transport != &b.transport)
+        throw std::logic_error("sharded matrices must have the same block size and transport");
+    Transport &transport = a.transport;
+    ShardedMatrix<T> c(transport, a.rows(), b.columns(), a.block);
+
+    std::vector<size_t> rowGroup, columnGroup;
+    for(size_t j = 0; j < c.gridColumns; ++j)
+        rowGroup.push_back(c.myRow * c.gridColumns + j);
+    for(size_t i = 0; i < c.gridRows; ++i)
+        columnGroup.push_back(i * c.gridColumns + c.myColumn);
+
+    size_t localRows = c.local_count_rows(), localColumns = c.local_count_columns();
+    std::vector<T> panelA, panelB;
+    std::vector<size_t> offsetA(localRows), offsetB(localColumns);
+    for(size_t k = 0; k < a.block_count_columns(); ++k){
+        size_t inner = a.block_columns(k);
+        //A(I, k) for local block rows I
+        size_t size = 0;
+        for(size_t li = 0; li < localRows; ++li){
+            offsetA[li] = size;
+            size += a.block_rows(li * c.gridRows + c.myRow) * inner;
+        }
+        panelA.resize(size);
+        size_t rootA = c.myRow * c.gridColumns + k % c.gridColumns;
+        if(transport.rank() == rootA)
+            for(size_t li = 0; li < localRows; ++li){
+                auto &local = a.local_block(li * c.gridRows + c.myRow, k);
+                std::copy(local.begin(), local.end(), panelA.begin() + offsetA[li]);
+            }
+        detail::broadcast(transport, rootA, rowGroup, panelA);
+
+        //B(k, J) for local block columns J
+        size = 0;
+        for(size_t lj = 0; lj < localColumns; ++lj){
+            offsetB[lj] = size;
+            size += inner * b.block_columns(lj * c.gridColumns + c.myColumn);
+        }
+        panelB.resize(size);
+        size_t rootB = (k % c.gridRows) * c.gridColumns + c.myColumn;
+        if(transport.rank() == rootB)
+            for(size_t lj = 0; lj < localColumns; ++lj){
+                auto &local = b.local_block(k, lj * c.gridColumns + c.myColumn);
+                std::copy(local.begin(), local.end(), panelB.begin() + offsetB[lj]);
+            }
+        detail::broadcast(transport, rootB, columnGroup, panelB);
+
+        for(size_t li = 0; li < localRows; ++li){
+            for(size_t lj = 0; lj < localColumns; ++lj){
+                auto &local = c.blocks[li * localColumns + lj];
+                detail::block_view<const T> l{panelA.data() + offsetA[li], local.rows(), inner, inner};
+                detail::block_view<const T> r{panelB.data() + offsetB[lj], inner, local.columns(), local.columns()};
+                detail::gemm(l, r, detail::view(local), true);
+            }
+        }
+    }
+    return c;
+}
+
+}
+#endif // DISTRIBUTED_H
@@ -0,0 +1,408 @@
+#ifndef EXACT_H
+#define EXACT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//================================exact integer elimination=======================================
+//================================================================================================
+#if defined(__SIZEOF_INT128__)
+using wide_int = __int128;
+#else
+using wide_int = long long;
+#endif
+
+//a * b - c * d, throws overflow_error, if any step does not fit wide_int
+inline wide_int checked_cross(wide_int a, wide_int b, wide_int c, wide_int d)
+{
+    wide_int ab, cd, r;
+#if defined(__GNUC__) || defined(__clang__)
+    if(__builtin_mul_overflow(a, b, &ab) || __builtin_mul_overflow(c, d, &cd) || __builtin_sub_overflow(ab, cd, &r))
+        throw std::overflow_error("intermediate value overflows");
+#else
+    const wide_int max = std::numeric_limits<wide_int>::max();
+    auto mul = [max](wide_int x, wide_int y){
+        if(x != 0 && y != 0 && (x > max / (y < 0 ? -y : y) || x < -max / (y < 0 ? -y : y)))
+            throw std::overflow_error("intermediate value overflows");
+        return x * y;
+    };
+    ab = mul(a, b);
+    cd = mul(c, d);
+    if((cd < 0 && ab > max + cd) || (cd > 0 && ab < -max + cd))
+        throw std::overflow_error("intermediate value overflows");
+    r = ab - cd;
+#endif
+    return r;
+}
+
+template <typename T>
+T narrow(wide_int value)
+{
+    if(value > wide_int(std::numeric_limits<T>::max()) || value < wide_int(std::numeric_limits<T>::lowest()))
+        throw std::overflow_error("determinant exceeds range of type");
+    return T(value);
+}
+
+//working buffers of elimination are taken from scratch arena of current thread
+using wide_vector = std::vector<wide_int, scratch_allocator<wide_int>>;
+
+//elements of matrix in row-major order as wide integers
+template <typename T>
+wide_vector wide_copy(const Matrix<T> &matrix)
+{
+    wide_vector a;
+    a.reserve(matrix.rows() * matrix.columns());
+    for(size_t i = 0; i < matrix.rows(); ++i)
+        for(size_t j = 0; j < matrix.columns(); ++j)
+            a.push_back(wide_int(type_is_t<T>(matrix(i, j))));
+    return a;
+}
+
+//fraction-free (Bareiss) row echelon form: every entry stays a minor of the matrix, so division by
+//the previous pivot is exact; rows below pivot are updated in parallel, returns rank and sign of row swaps
+inline size_t bareiss(wide_vector &a, size_t rows, size_t columns, int &sign, wide_int &last)
+{
+    sign = 1;
+    wide_int previous = 1;
+    size_t rank = 0;
+    for(size_t c = 0; c < columns && rank < rows; ++c){
+        size_t pivot = rank;
+        while(pivot < rows && a[pivot * columns + c] == 0)
+            ++pivot;
+        if(pivot == rows)
+            continue;
+        if(pivot != rank){
+            std::swap_ranges(a.begin() + std::ptrdiff_t(pivot * columns), a.begin() + std::ptrdiff_t(pivot * columns + columns),
+                             a.begin() + std::ptrdiff_t(rank * columns));
+            sign = -sign;
+        }
+        const wide_int *r = a.data() + rank * columns;
+        wide_int p = r[c];
+        parallel_for(rank + 1, rows, parallel_grain(columns - c), [&](size_t b, size_t e){
+            for(size_t i = b; i < e; ++i){
+                wide_int *row = a.data() + i * columns;
+                wide_int factor = row[c];
+                for(size_t j = c + 1; j < columns; ++j)
+                    row[j] = checked_cross(row[j], p, factor, r[j]) / previous;
+                row[c] = 0;
+            }
+        });
+        previous = p;
+        last = p;
+        ++rank;
+    }
+    return rank;
+}
+
+//---------------------------------------modular------------------------------------------------
+inline uint64_t mod_pow(uint64_t base, uint64_t exponent, uint64_t p)
+{
+    uint64_t result = 1;
+    base %= p;
+    for(; exponent; exponent >>= 1){
+        if(exponent & 1)
+            result = result * base % p;
+        base = base * base % p;
+    }
+    return result;
+}
+
+//deterministic Miller-Rabin for 32-bit numbers
+inline bool is_prime(uint64_t n)
+{
+    if(n < 2)
+        return false;
+    for(uint64_t p: {2, 3, 5, 7})
+        if(n % p == 0)
+            return n == p;
+    uint64_t d = n - 1;
+    int s = 0;
+    for(; d % 2 == 0; d /= 2)
+        ++s;
+    for(uint64_t a: {2, 7, 61}){
+        if(a % n == 0)
+            continue;
+        uint64_t x = mod_pow(a, d, n);
+        if(x == 1 || x == n - 1)
+            continue;
+        bool composite = true;
+        for(int r = 1; r < s && composite; ++r){
+            x = x * x % n;
+            composite = x != n - 1;
+        }
+        if(composite)
+            return false;
+    }
+    return true;
+}
+
+//amount primes below 2^31, products of two residues fit uint64_t
+inline std::vector<uint64_t> large_primes(size_t amount)
+{
+    static std::vector<uint64_t> primes;
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    for(uint64_t n = primes.empty() ? (uint64_t(1) << 31) - 1 : primes.back() - 2; primes.size() < amount; n -= 2)
+        if(is_prime(n))
+            primes.push_back(n);
+    return std::vector<uint64_t>(primes.begin(), primes.begin() + std::ptrdiff_t(amount));
+}
+
+inline uint64_t to_residue(wide_int value, uint64_t p)
+{
+    wide_int r = value % wide_int(p);
+    return uint64_t(r < 0 ? r + wide_int(p) : r);
+}
+
+//Gaussian elimination modulo p, returns rank, det is determinant modulo p for square matrix
+inline size_t modular_elimination(const wide_vector &matrix, size_t rows, size_t columns,
+                                  uint64_t p, uint64_t &det)
+{
+    std::vector<uint64_t> a(matrix.size());
+    for(size_t i = 0; i < a.size(); ++i)
+        a[i] = to_residue(matrix[i], p);
+    det = 1;
+    size_t rank = 0;
+    for(size_t c = 0; c < columns && rank < rows; ++c){
+        size_t pivot = rank;
+        while(pivot < rows && a[pivot * columns + c] == 0)
+            ++pivot;
+        if(pivot == rows){
+            det = 0;
+            continue;
+        }
+        if(pivot != rank){
+            std::swap_ranges(a.begin() + std::ptrdiff_t(pivot * columns), a.begin() + std::ptrdiff_t(pivot * columns + columns),
+                             a.begin() + std::ptrdiff_t(rank * columns));
+            det = (p - det) % p;
+        }
+        const uint64_t *r = a.data() + rank * columns;
+        det = det * r[c] % p;
+        uint64_t inverse = mod_pow(r[c], p - 2, p);
+        for(size_t i = rank + 1; i < rows; ++i){
+            uint64_t *row = a.data() + i * columns;
+            uint64_t factor = row[c] * inverse % p;
+            if(factor == 0)
+                continue;
+            for(size_t j = c; j < columns; ++j)
+                row[j] = (row[j] + (p - factor) * r[j]) % p;
+        }
+        ++rank;
+    }
+    return rank;
+}
+
+//log2 of Hadamard bound of determinant: product of euclidean norms of rows
+inline double log2_hadamard(const wide_vector &a, size_t n)
+{
+    double bound = 0;
+    for(size_t i = 0; i < n; ++i){
+        long double norm = 0;
+        for(size_t j = 0; j < n; ++j)
+            norm += (long double)a[i * n + j] * (long double)a[i * n + j];
+        if(norm == 0)
+            return 0;
+        bound += 0.5 * double(std::log2(norm));
+    }
+    return bound;
+}
+
+//symmetric residue of x modulo p in (-p/2, p/2]
+inline int64_t symmetric(uint64_t x, uint64_t p)
+{
+    return x > p / 2 ? int64_t(x) - int64_t(p) : int64_t(x);
+}
+
+//Garner reconstruction with symmetric mixed-radix digits: value in (-M/2, M/2], M = product of primes,
+//Horner evaluation from the highest digit throws, if value does not fit wide_int
+inline wide_int garner(const std::vector<uint64_t> &residues, const std::vector<uint64_t> &primes)
+{
+    size_t k = primes.size();
+    std::vector<int64_t> digits(k);
+    for(size_t i = 0; i < k; ++i){
+        uint64_t p = primes[i];
+        //value of lower digits and product of lower primes modulo p
+        uint64_t value = 0, radix = 1;
+        for(size_t j = 0; j < i; ++j){
+            uint64_t digit = uint64_t((digits[j] % int64_t(p) + int64_t(p)) % int64_t(p));
+            value = (value + digit * radix) % p;
+            radix = radix * (primes[j] % p) % p;
+        }
+        uint64_t t = (residues[i] + p - value) % p * mod_pow(radix, p - 2, p) % p;
+        digits[i] = symmetric(t, p);
+    }
+    wide_int x = 0;
+    for(size_t i = k; i-- > 0;)
+        x = checked_cross(x, wide_int(primes[i]), -1, digits[i]);
+    return x;
+}
+
+template <typename T>
+T modular_det(const wide_vector &a, size_t n)
+{
+    //primes are > 2^30, their product must exceed twice Hadamard bound
+    size_t amount = size_t(std::ceil((log2_hadamard(a, n) + 2) / 30)) + 1;
+    auto primes = large_primes(amount);
+    std::vector<uint64_t> residues(amount);
+    parallel_for(0, amount, 1, [&](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i)
+            modular_elimination(a, n, n, primes[i], residues[i]);
+    });
+    return narrow<T>(garner(residues, primes));
+}
+
+//rank modulo p is not greater than rank over rationals and equals it for all primes, which do not
+//divide one nonzero maximal minor, so maximum over several large primes is exact with overwhelming probability
+inline size_t modular_rank(const wide_vector &a, size_t rows, size_t columns)
+{
+    auto primes = large_primes(4);
+    std::vector<size_t> ranks(primes.size());
+    parallel_for(0, primes.size(), 1, [&](size_t b, size_t e){
+        uint64_t det;
+        for(size_t i = b; i < e; ++i)
+            ranks[i] = modular_elimination(a, rows, columns, primes[i], det);
+    });
+    return *std::max_element(ranks.begin(), ranks.end());
+}
+
+//cofactor expansion along the first row, minors of every level share one scratch buffer
+template <typename T>
+T cofactor_det(const T *a, size_t n)
+{
+    if(n == 1)
+        return a[0];
+    if(n == 2)
+        return a[0] * a[3] - a[1] * a[2];
+    ScratchScope scope;
+    T *minor = scope.allocate<T>((n - 1) * (n - 1));
+    T det = 0;
+    int degree = 1;
+    for(size_t j = 0; j < n; ++j){
+        for(size_t i = 1; i < n; ++i)
+            for(size_t k = 0, t = 0; k < n; ++k)
+                if(k != j)
+                    minor[(i - 1) * (n - 1) + t++] = a[i * n + k];
+        det = det + degree * a[j] * cofactor_det(minor, n - 1);
+        degree = -degree;
+    }
+    return det;
+}
+
+template <typename T>
+T exact_det(const Matrix<T> &matrix, ExactMethod method)
+{
+    size_t n = matrix.rows();
+    if(n == 0)
+        return T();
+    ScratchScope scope;
+    auto a = wide_copy(matrix);
+    if(method != ExactMethod::Modular){
+        try{
+            auto copy = method == ExactMethod::Auto ? a : std::move(a);
+            int sign;
+            wide_int last = 0;
+            if(bareiss(copy, n, n, sign, last) < n)
+                return T();
+            return narrow<type_is_t<T>>(sign * last);
+        }
+        catch(const std::overflow_error&){
+            if(method == ExactMethod::Bareiss)
+                throw;
+        }
+    }
+    return modular_det<type_is_t<T>>(a, n);
+}
+
+template <typename T>
+size_t exact_rank(const Matrix<T> &matrix, ExactMethod method)
+{
+    ScratchScope scope;
+    auto a = wide_copy(matrix);
+    if(method != ExactMethod::Modular){
+        try{
+            auto copy = method == ExactMethod::Auto ? a : std::move(a);
+            int sign;
+            wide_int last;
+            return bareiss(copy, matrix.rows(), matrix.columns(), sign, last);
+        }
+        catch(const std::overflow_error&){
+            if(method == ExactMethod::Bareiss)
+                throw;
+        }
+    }
+    return modular_rank(a, matrix.rows(), matrix.columns());
+}
+
+//Gaussian elimination with partial pivoting, pivots below tolerance are zeros
+template <typename T>
+size_t floating_rank(const Matrix<T> &matrix)
+{
+    using R = real_type_t<T>;
+    size_t rows = matrix.rows(), columns = matrix.columns();
+    std::vector<R> a;
+    a.reserve(rows * columns);
+    R largest = 0;
+    for(size_t i = 0; i < rows; ++i)
+        for(size_t j = 0; j < columns; ++j){
+            a.push_back(R(type_is_t<T>(matrix(i, j))));
+            largest = std::max(largest, std::fabs(a.back()));
+        }
+    R tolerance = largest * R(std::max(rows, columns)) * std::numeric_limits<R>::epsilon();
+    size_t rank = 0;
+    for(size_t c = 0; c < columns && rank < rows; ++c){
+        size_t pivot = rank;
+        for(size_t i = rank + 1; i < rows; ++i)
+            if(std::fabs(a[i * columns + c]) > std::fabs(a[pivot * columns + c]))
+                pivot = i;
+        if(std::fabs(a[pivot * columns + c]) <= tolerance)
+            continue;
+        std::swap_ranges(a.begin() + std::ptrdiff_t(pivot * columns), a.begin() + std::ptrdiff_t(pivot * columns + columns),
+                         a.begin() + std::ptrdiff_t(rank * columns));
+        const R *r = a.data() + rank * columns;
+        for(size_t i = rank + 1; i < rows; ++i){
+            R *row = a.data() + i * columns;
+            R factor = row[c] / r[c];
+            for(size_t j = c; j < columns; ++j)
+                row[j] -= factor * r[j];
+        }
+        ++rank;
+    }
+    return rank;
+}
+}
+
+//================================================================================================
+//=====================================det and rank===============================================
+//================================================================================================
+template<typename T>
+T Matrix<T>::det(ExactMethod method) const {
+    if(amountRows != amountColumns)
+        throw std::length_error("matrix must be square");
+    if constexpr(std::is_integral_v<type_is_t<T>>)
+        return detail::exact_det(*this, method);
+    else
+        return amountRows ? detail::cofactor_det(data(), amountRows) : T();
+}
+
+template<typename T>
+size_t Matrix<T>::rank(ExactMethod method) const
+{
+    if constexpr(std::is_integral_v<type_is_t<T>>)
+        return detail::exact_rank(*this, method);
+    else
+        return detail::floating_rank(*this);
+}
+
+}
+#endif // EXACT_H
@@ -0,0 +1,250 @@
+#ifndef EXTERNAL_H
+#define EXTERNAL_H
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_mdspan)
+#include <mdspan>
+#endif
+
+namespace matrix_view {
+
+//================================================================================================
+//=====================================external matrices==========================================
+//================================================================================================
+//rows x columns matrix over external row-major buffer, row i starts at data + i * ld;
+//it does not copy elements, the buffer is owned only if a deleter is given, copies share ownership.
+//T may be const for read-only buffers. Accessors extent(r), stride(r) and data_handle() follow
+//std::mdspan with layout_stride, so generic mdspan code can take it as is
+template <typename T>
+class ExternalMatrix{
+public:
+    using value_type = std::remove_const_t<T>;
+
+    ExternalMatrix(T *data_, size_t amountRows_, size_t amountColumns_);
+    ExternalMatrix(T *data_, size_t amountRows_, size_t amountColumns_, size_t ld_);
+    //takes ownership of buffer, deleter(data_) is called, when the last copy is destroyed
+    template <typename Deleter>
+    ExternalMatrix(T *data_, size_t amountRows_, size_t amountColumns_, size_t ld_, Deleter deleter);
+    //view of matrix, which must outlive it
+    template <typename M, typename = std::enable_if_t<is_matrix_v<std::decay_t<M>> &&
+                                                      std::is_convertible_v<decltype(std::declval<M&>().data()), T*>>>
+    ExternalMatrix(M &matrix);
+#if defined(__cpp_lib_mdspan)
+    template <typename Extents, typename Layout, typename Accessor>
+    ExternalMatrix(const std::mdspan<T, Extents, Layout, Accessor> &span);
+    std::mdspan<T, std::dextents<size_t, 2>, std::layout_stride> to_mdspan() const;
+#endif
+
+    size_t rows() const;
+    size_t columns() const;
+    size_t ld() const;
+    bool contiguous() const;
+    T *data() const;
+    T *row(size_t i) const;
+    T &operator()(size_t i, size_t j) const;
+
+    size_t extent(size_t r) const;
+    size_t stride(size_t r) const;
+    T *data_handle() const;
+
+    //view of r x c block at (i, j), shares ownership
+    ExternalMatrix block(size_t i, size_t j, size_t r, size_t c) const;
+    //dense copy
+    Matrix<value_type> to_matrix() const;
+    Matrix<value_type> dot(const Matrix<value_type> &other) const;
+
+private:
+    T *p;
+    size_t amountRows;
+    size_t amountColumns;
+    size_t leading;
+    std::shared_ptr<void> owner;
+};
+
+template <typename T, typename U>
+Matrix<std::remove_const_t<T>> dot(const ExternalMatrix<T> &a, const ExternalMatrix<U> &b);
+template <typename T, typename U>
+Matrix<std::remove_const_t<T>> dot(const Matrix<T> &a, const ExternalMatrix<U> &b);
+
+namespace detail{
+template <typename T>
+block_view<const std::remove_const_t<T>> view(const ExternalMatrix<T> &matrix)
+{
+    return {matrix.data(), matrix.rows(), matrix.columns(), matrix.ld()};
+}
+
+template <typename T, typename U>
+Matrix<T> external_product(block_view<const T> a, block_view<const U> b)
+{
+    static_assert(std::is_same_v<T, U>, "matrices must have the same element type");
+    if(a.columns != b.rows)
+        throw std::length_error("Inner matrix dimensions must agree");
+    Matrix<T> res(a.rows, b.columns);
+    gemm(a, b, view(res));
+    return res;
+}
+}
+
+template <typename T>
+ExternalMatrix<T>::ExternalMatrix(T *data_, size_t amountRows_, size_t amountColumns_):
+    ExternalMatrix(data_, amountRows_, amountColumns_, amountColumns_)
+{
+}
+
+template <typename T>
+ExternalMatrix<T>::ExternalMatrix(T *data_, size_t amountRows_, size_t amountColumns_, size_t ld_):
+    p(data_), amountRows(amountRows_), amountColumns(amountColumns_), leading(ld_)
+{
+    if(leading < amountColumns && amountRows > 1)
+        throw std::logic_error("wrong range");
+}
+
+template <typename T>
+template <typename Deleter>
+ExternalMatrix<T>::ExternalMatrix(T *data_, size_t amountRows_, size_t amountColumns_, size_t ld_, Deleter deleter):
+    p(data_), amountRows(amountRows_), amountColumns(amountColumns_), leading(ld_),
+    owner(static_cast<void*>(const_cast<value_type*>(data_)), [deleter, data_](void*) mutable { deleter(data_); })
+{
+    //buffer is owned before the check, so it is freed, if shape is wrong
+    if(leading < amountColumns && amountRows > 1)
+        throw std::logic_error("wrong range");
+}
+
+template <typename T>
+template <typename M, typename>
+ExternalMatrix<T>::ExternalMatrix(M &matrix):
+    ExternalMatrix(matrix.data(), matrix.rows(), matrix.columns())
+{
+}
+
+#if defined(__cpp_lib_mdspan)
+template <typename T>
+template <typename Extents, typename Layout, typename Accessor>
+ExternalMatrix<T>::ExternalMatrix(const std::mdspan<T, Extents, Layout, Accessor> &span):
+    ExternalMatrix(span.data_handle(), span.extent(0), span.extent(1), span.stride(0))
+{
+    static_assert(Extents::rank() == 2, "mdspan must have rank 2");
+    if(span.extent(0) && span.extent(1) > 1 && span.stride(1) != 1)
+        throw std::logic_error("wrong range");
+}
+
+template <typename T>
+std::mdspan<T, std::dextents<size_t, 2>, std::layout_stride> ExternalMatrix<T>::to_mdspan() const
+{
+    using extents = std::dextents<size_t, 2>;
+    return {p, std::layout_stride::mapping<extents>(extents(amountRows, amountColumns), std::array<size_t, 2>{leading, 1})};
+}
+#endif
+
+template <typename T>
+size_t ExternalMatrix<T>::rows() const
+{
+    return amountRows;
+}
+
+template <typename T>
+size_t ExternalMatrix<T>::columns() const
+{
+    return amountColumns;
+}
+
+template <typename T>
+size_t ExternalMatrix<T>::ld() const
+{
+    return leading;
+}
+
+template <typename T>
+bool ExternalMatrix<T>::contiguous() const
+{
+    return leading == amountColumns || amountRows <= 1;
+}
+
+template <typename T>
+T *ExternalMatrix<T>::data() const
+{
+    return p;
+}
+
+template <typename T>
+T *ExternalMatrix<T>::row(size_t i) const
+{
+    return p + i * leading;
+}
+
+template <typename T>
+T &ExternalMatrix<T>::operator()(size_t i, size_t j) const
+{
+    if(i >= amountRows || j >= amountColumns)
+        throw std::out_of_range("Index exceeds matrix dimensions.");
+    return p[i * leading + j];
+}
+
+template <typename T>
+size_t ExternalMatrix<T>::extent(size_t r) const
+{
+    return r ? amountColumns : amountRows;
+}
+
+template <typename T>
+size_t ExternalMatrix<T>::stride(size_t r) const
+{
+    return r ? 1 : leading;
+}
+
+template <typename T>
+T *ExternalMatrix<T>::data_handle() const
+{
+    return p;
+}
+
+template <typename T>
+ExternalMatrix<T> ExternalMatrix<T>::block(size_t i, size_t j, size_t r, size_t c) const
+{
+    if(i + r > amountRows || j + c > amountColumns)
+        throw std::out_of_range("Index exceeds matrix dimensions.");
+    ExternalMatrix res(p + i * leading + j, r, c, leading);
+    res.owner = owner;
+    return res;
+}
+
+template <typename T>
+Matrix<typename ExternalMatrix<T>::value_type> ExternalMatrix<T>::to_matrix() const
+{
+    Matrix<value_type> res(amountRows, amountColumns);
+    detail::parallel_for(0, amountRows, detail::parallel_grain(amountColumns), [&](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i)
+            std::copy(row(i), row(i) + amountColumns, res.data() + i * amountColumns);
+    });
+    return res;
+}
+
+template <typename T>
+Matrix<typename ExternalMatrix<T>::value_type> ExternalMatrix<T>::dot(const Matrix<value_type> &other) const
+{
+    return detail::external_product(detail::view(*this), detail::view(other));
+}
+
+template <typename T, typename U>
+Matrix<std::remove_const_t<T>> dot(const ExternalMatrix<T> &a, const ExternalMatrix<U> &b)
+{
+    return detail::external_product(detail::view(a), detail::view(b));
+}
+
+template <typename T, typename U>
+Matrix<std::remove_const_t<T>> dot(const Matrix<T> &a, const ExternalMatrix<U> &b)
+{
+    return detail::external_product(detail::view(a), detail::view(b));
+}
+
+}
+#endif // EXTERNAL_H
@@ -0,0 +1,381 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <algorithm>
+#include <vector>
+
+#include <Matrix/helper.h>
+#include <Matrix/parallel.h>
+
+namespace matrix_view {
+
+//algorithm of dot product
+enum class Product{ Blocked, Strassen };
+
+namespace detail{
+//================================================================================================
+//=====================================product kernels============================================
+//================================================================================================
+//sizes of blocks and crossover of product kernels
+struct GemmParams{
+    //rows of C computed by one task
+    size_t blockRows = 64;
+    //inner dimension of block, rows of B panel
+    size_t blockInner = 128;
+    //columns of B panel, blockInner x blockColumns should stay in L2 cache
+    size_t blockColumns = 256;
+    //Strassen recursion falls back to blocked kernel, if any dimension is not greater
+    size_t strassenCrossover = 512;
+};
+
+//autotune changes it, it is not synchronized with running products
+inline GemmParams gemm_params;
+
+//transpose moves tile x tile blocks, so rows of source and destination stay in cache
+struct TransposeParams{
+    size_t tile = 32;
+};
+
+inline TransposeParams transpose_params;
+
+//rows x columns block of row-major buffer with leading dimension ld
+template <typename T>
+struct block_view{
+    T* p;
+    size_t rows;
+    size_t columns;
+    size_t ld;
+
+    T* row(size_t i) const { return p + i * ld; }
+    block_view block(size_t i, size_t j, size_t r, size_t c) const
+    {
+        return {p + i * ld + j, r, c, ld};
+    }
+    operator block_view<const T>() const { return {p, rows, columns, ld}; }
+};
+
+//rows [rb, re) of C = A * B (C += A * B if accumulate), 4 rows of C share every row of B panel
+template <typename T>
+void gemm_rows(block_view<const T> a, block_view<const T> b, block_view<T> c,
+               bool accumulate, size_t rb, size_t re, const GemmParams &params)
+{
+    size_t inner = a.columns, columns = b.columns;
+    if(!accumulate)
+        for(size_t i = rb; i < re; ++i)
+            std::fill(c.row(i), c.row(i) + columns, T());
+
+    for(size_t i0 = rb; i0 < re; i0 += params.blockRows){
+        size_t i1 = std::min(i0 + params.blockRows, re);
+        for(size_t k0 = 0; k0 < inner; k0 += params.blockInner){
+            size_t k1 = std::min(k0 + params.blockInner, inner);
+            for(size_t j0 = 0; j0 < columns; j0 += params.blockColumns){
+                size_t j1 = std::min(j0 + params.blockColumns, columns);
+                size_t i = i0;
+                for(; i + 4 <= i1; i += 4){
+                    T* c0 = c.row(i);
+                    T* c1 = c.row(i + 1);
+                    T* c2 = c.row(i + 2);
+                    T* c3 = c.row(i + 3);
+                    for(size_t k = k0; k < k1; ++k){
+                        const T* bk = b.row(k);
+                        T a0 = a.row(i)[k], a1 = a.row(i + 1)[k], a2 = a.row(i + 2)[k], a3 = a.row(i + 3)[k];
+                        for(size_t j = j0; j < j1; ++j){
+                            T bkj = bk[j];
+                            c0[j] += a0 * bkj;
+                            c1[j] += a1 * bkj;
+                            c2[j] += a2 * bkj;
+                            c3[j] += a3 * bkj;
+                        }
+                    }
+                }
+                for(; i < i1; ++i){
+                    T* ci = c.row(i);
+                    for(size_t k = k0; k < k1; ++k){
+                        const T* bk = b.row(k);
+                        T aik = a.row(i)[k];
+                        for(size_t j = j0; j < j1; ++j)
+                            ci[j] += aik * bk[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+//C = A * B (C += A * B if accumulate), blocks of rows of C are computed in parallel
+template <typename T>
+void gemm(block_view<const T> a, block_view<const T> b, block_view<T> c, bool accumulate = false)
+{
+    const GemmParams params = gemm_params;
+    parallel_rows(0, a.rows, parallel_grain(a.columns * b.columns), [&](size_t rb, size_t re){
+        gemm_rows(a, b, c, accumulate, rb, re, params);
+    });
+}
+
+//------------------------------matrix-vector kernels-------------------------------------------
+//sum a[i] * b[i] with simd_lanes accumulators
+template <typename T>
+T dot_kernel(const T* a, const T* b, size_t n)
+{
+    T lanes[simd_lanes] = {};
+    size_t i = 0;
+    for(; i + simd_lanes <= n; i += simd_lanes)
+        for(size_t l = 0; l < simd_lanes; ++l)
+            lanes[l] += a[i + l] * b[i + l];
+    for(size_t l = 0; i < n; ++i, ++l)
+        lanes[l] += a[i] * b[i];
+    for(size_t width = simd_lanes / 2; width > 0; width /= 2)
+        for(size_t l = 0; l < width; ++l)
+            lanes[l] += lanes[l + width];
+    return lanes[0];
+}
+
+//y = alpha * A x + beta * y, rows of A are streamed once, blocks of rows run in parallel
+template <typename T>
+void gemv(T alpha, block_view<const T> a, const T* x, T beta, T* y)
+{
+    parallel_for(0, a.rows, parallel_grain(a.columns), [&](size_t rb, size_t re){
+        for(size_t i = rb; i < re; ++i){
+            T sum = dot_kernel(a.row(i), x, a.columns);
+            y[i] = beta == T() ? alpha * sum : alpha * sum + beta * y[i];
+        }
+    });
+}
+
+//y = alpha * A^T x + beta * y, A is streamed row by row,
+//threads take strips of columns, so every element of y is written by one thread
+template <typename T>
+void gemv_transposed(T alpha, block_view<const T> a, const T* x, T beta, T* y)
+{
+    parallel_for(0, a.columns, parallel_grain(a.rows), [&](size_t jb, size_t je){
+        for(size_t j = jb; j < je; ++j)
+            y[j] = beta == T() ? T() : beta * y[j];
+        for(size_t i = 0; i < a.rows; ++i){
+            const T* ai = a.row(i);
+            T axi = alpha * x[i];
+            for(size_t j = jb; j < je; ++j)
+                y[j] += axi * ai[j];
+        }
+    });
+}
+
+//A += alpha * x y^T, blocks of rows run in parallel
+template <typename T>
+void rank1_update(block_view<T> a, T alpha, const T* x, const T* y)
+{
+    parallel_for(0, a.rows, parallel_grain(a.columns), [&](size_t rb, size_t re){
+        for(size_t i = rb; i < re; ++i){
+            T* ai = a.row(i);
+            T axi = alpha * x[i];
+            for(size_t j = 0; j < a.columns; ++j)
+                ai[j] += axi * y[j];
+        }
+    });
+}
+
+//out = a + sign * b element-wise, out may be a or b
+template <typename T>
+void add(block_view<const T> a, block_view<const T> b, block_view<T> out, int sign)
+{
+    parallel_for(0, out.rows, parallel_grain(out.columns), [&](size_t rb, size_t re){
+        for(size_t i = rb; i < re; ++i){
+            const T* ai = a.row(i);
+            const T* bi = b.row(i);
+            T* oi = out.row(i);
+            if(sign > 0)
+                for(size_t j = 0; j < out.columns; ++j)
+                    oi[j] = ai[j] + bi[j];
+            else
+                for(size_t j = 0; j < out.columns; ++j)
+                    oi[j] = ai[j] - bi[j];
+        }
+    });
+}
+
+//---------------------------------Strassen-Winograd---------------------------------------------
+inline bool strassen_base(size_t m, size_t k, size_t n, size_t crossover)
+{
+    return std::min({m, k, n}) <= std::max<size_t>(crossover, 1);
+}
+
+//workspace of strassen_sequential: X (m/2 x max(k/2, n/2)) and Y (k/2 x n/2) on every level
+inline size_t strassen_workspace(size_t m, size_t k, size_t n, size_t crossover)
+{
+    if(strassen_base(m, k, n, crossover))
+        return 0;
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    return m2 * std::max(k2, n2) + k2 * n2 + strassen_workspace(m2, k2, n2, crossover);
+}
+
+//workspace of strassen_parallel: S1..S4, T1..T4, P1, P6, P7 and workspaces of 7 products
+inline size_t strassen_parallel_workspace(size_t m, size_t k, size_t n, size_t crossover)
+{
+    if(strassen_base(m, k, n, crossover))
+        return 0;
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    return 4 * m2 * k2 + 4 * k2 * n2 + 3 * m2 * n2 + 7 * strassen_workspace(m2, k2, n2, crossover);
+}
+
+//odd last row, column or inner index are computed by blocked kernel (dynamic peeling)
+template <typename T>
+void strassen_peel(block_view<const T> a, block_view<const T> b, block_view<T> c)
+{
+    size_t m = a.rows, k = a.columns, n = b.columns;
+    size_t me = m / 2 * 2, ke = k / 2 * 2, ne = n / 2 * 2;
+    if(ke != k)
+        gemm(a.block(0, ke, me, k - ke), b.block(ke, 0, k - ke, ne), c.block(0, 0, me, ne), true);
+    if(ne != n)
+        gemm(a, b.block(0, ne, k, n - ne), c.block(0, ne, m, n - ne));
+    if(me != m)
+        gemm(a.block(me, 0, m - me, k), b.block(0, 0, k, ne), c.block(me, 0, m - me, ne));
+}
+
+//C = A * B with 7 recursive products and 2 temporaries per level
+//(Boyer, Dumas, Pernet, Zhou "Memory efficient scheduling of Strassen-Winograd's algorithm")
+template <typename T>
+void strassen_sequential(block_view<const T> a, block_view<const T> b, block_view<T> c,
+                         T* work, size_t crossover)
+{
+    size_t m = a.rows, k = a.columns, n = b.columns;
+    if(strassen_base(m, k, n, crossover)){
+        gemm(a, b, c);
+        return;
+    }
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    auto a11 = a.block(0, 0, m2, k2), a12 = a.block(0, k2, m2, k2);
+    auto a21 = a.block(m2, 0, m2, k2), a22 = a.block(m2, k2, m2, k2);
+    auto b11 = b.block(0, 0, k2, n2), b12 = b.block(0, n2, k2, n2);
+    auto b21 = b.block(k2, 0, k2, n2), b22 = b.block(k2, n2, k2, n2);
+    auto c11 = c.block(0, 0, m2, n2), c12 = c.block(0, n2, m2, n2);
+    auto c21 = c.block(m2, 0, m2, n2), c22 = c.block(m2, n2, m2, n2);
+    block_view<T> x{work, m2, k2, k2};
+    block_view<T> xp{work, m2, n2, n2};
+    block_view<T> y{work + m2 * std::max(k2, n2), k2, n2, n2};
+    T* next = y.p + k2 * n2;
+    auto mul = [next, crossover](block_view<const T> l, block_view<const T> r, block_view<T> out){
+        strassen_sequential(l, r, out, next, crossover);
+    };
+
+    add<T>(a11, a21, x, -1);    //S3
+    add<T>(b22, b12, y, -1);    //T3
+    mul(x, y, c21);             //P7
+    add<T>(a21, a22, x, 1);     //S1
+    add<T>(b12, b11, y, -1);    //T1
+    mul(x, y, c22);             //P5
+    add<T>(b22, y, y, -1);      //T2
+    add<T>(x, a11, x, -1);      //S2
+    mul(x, y, c12);             //P6
+    add<T>(a12, x, x, -1);      //S4
+    mul(x, b22, c11);           //P3
+    mul(a11, b11, xp);          //P1
+    add<T>(xp, c12, c12, 1);    //U2 = P1 + P6
+    add<T>(c12, c21, c21, 1);   //U3 = U2 + P7
+    add<T>(c12, c22, c12, 1);   //U4 = U2 + P5
+    add<T>(c21, c22, c22, 1);   //U7 = U3 + P5
+    add<T>(c12, c11, c12, 1);   //U5 = U4 + P3
+    add<T>(y, b21, y, -1);      //T4
+    mul(a22, y, c11);           //P4
+    add<T>(c21, c11, c21, -1);  //U6 = U3 - P4
+    mul(a12, b21, c11);         //P2
+    add<T>(xp, c11, c11, 1);    //U1 = P1 + P2
+
+    strassen_peel(a, b, c);
+}
+
+//C = A * B, 7 products of the first level run in parallel, deeper levels are sequential
+template <typename T>
+void strassen_parallel(block_view<const T> a, block_view<const T> b, block_view<T> c,
+                       T* work, size_t crossover)
+{
+    size_t m = a.rows, k = a.columns, n = b.columns;
+    if(strassen_base(m, k, n, crossover)){
+        gemm(a, b, c);
+        return;
+    }
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    auto a11 = a.block(0, 0, m2, k2), a12 = a.block(0, k2, m2, k2);
+    auto a21 = a.block(m2, 0, m2, k2), a22 = a.block(m2, k2, m2, k2);
+    auto b11 = b.block(0, 0, k2, n2), b12 = b.block(0, n2, k2, n2);
+    auto b21 = b.block(k2, 0, k2, n2), b22 = b.block(k2, n2, k2, n2);
+    auto c11 = c.block(0, 0, m2, n2), c12 = c.block(0, n2, m2, n2);
+    auto c21 = c.block(m2, 0, m2, n2), c22 = c.block(m2, n2, m2, n2);
+
+    auto take = [&work](size_t rows, size_t columns){
+        block_view<T> v{work, rows, columns, columns};
+        work += rows * columns;
+        return v;
+    };
+    auto s1 = take(m2, k2), s2 = take(m2, k2), s3 = take(m2, k2), s4 = take(m2, k2);
+    auto t1 = take(k2, n2), t2 = take(k2, n2), t3 = take(k2, n2), t4 = take(k2, n2);
+    auto p1 = take(m2, n2), p6 = take(m2, n2), p7 = take(m2, n2);
+
+    add<T>(a21, a22, s1, 1);
+    add<T>(s1, a11, s2, -1);
+    add<T>(a11, a21, s3, -1);
+    add<T>(a12, s2, s4, -1);
+    add<T>(b12, b11, t1, -1);
+    add<T>(b22, t1, t2, -1);
+    add<T>(b22, b12, t3, -1);
+    add<T>(t2, b21, t4, -1);
+
+    //P2, P3, P4, P5 are stored in C11, C12, C21, C22
+    struct task{ block_view<const T> l, r; block_view<T> out; };
+    const task tasks[7] = {{a11, b11, p1}, {a12, b21, c11}, {s4, b22, c12}, {a22, t4, c21},
+                           {s1, t1, c22}, {s2, t2, p6}, {s3, t3, p7}};
+    size_t childWork = strassen_workspace(m2, k2, n2, crossover);
+    parallel_for(0, 7, 1, [&](size_t tb, size_t te){
+        for(size_t i = tb; i < te; ++i)
+            strassen_sequential(tasks[i].l, tasks[i].r, tasks[i].out, work + i * childWork, crossover);
+    });
+
+    add<T>(c11, p1, c11, 1);    //U1 = P1 + P2
+    add<T>(p1, p6, p6, 1);      //U2 = P1 + P6
+    add<T>(p6, p7, p7, 1);      //U3 = U2 + P7
+    add<T>(c12, p6, c12, 1);    //P3 + U2
+    add<T>(c12, c22, c12, 1);   //U5 = U2 + P5 + P3
+    add<T>(p7, c21, c21, -1);   //U6 = U3 - P4
+    add<T>(p7, c22, c22, 1);    //U7 = U3 + P5
+
+    strassen_peel(a, b, c);
+}
+
+//C = A * B by Strassen-Winograd algorithm, all temporaries are in one workspace,
+//work keeps its capacity between calls
+template <typename T>
+void strassen(block_view<const T> a, block_view<const T> b, block_view<T> c, std::vector<T>& work)
+{
+    size_t crossover = gemm_params.strassenCrossover;
+    size_t m = a.rows, k = a.columns, n = b.columns;
+    if(hardware_threads() > 1 && !in_parallel){
+        work.resize(strassen_parallel_workspace(m, k, n, crossover));
+        strassen_parallel(a, b, c, work.data(), crossover);
+    }
+    else{
+        work.resize(strassen_workspace(m, k, n, crossover));
+        strassen_sequential(a, b, c, work.data(), crossover);
+    }
+}
+
+template <typename T>
+void strassen(block_view<const T> a, block_view<const T> b, block_view<T> c)
+{
+    std::vector<T> work;
+    strassen(a, b, c, work);
+}
+
+//C = A * B by the fastest kernel for these sizes, work keeps its capacity between calls
+template <typename T>
+void product(block_view<const T> a, block_view<const T> b, block_view<T> c, std::vector<T>& work)
+{
+    if(b.columns == 1)
+        gemv(T(1), a, b.p, T(), c.p);
+    else if(!strassen_base(a.rows, a.columns, b.columns, 2 * gemm_params.strassenCrossover))
+        strassen(a, b, c, work);
+    else
+        gemm(a, b, c);
+}
+
+}
+
+}
+#endif // GEMM_H
@@ -0,0 +1,170 @@
+#ifndef GRAM_H
+#define GRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//=========================================SYRK kernel============================================
+//================================================================================================
+//rows packed at once and width of triangle tiles
+inline constexpr size_t syrk_rows = 64;
+inline constexpr size_t syrk_tile = 64;
+
+//upper triangle tiles [first, last) of sum over rows [rb, re) of a^T a, a = x - shift, are added to acc (p x p);
+//tiles are numbered by rows of the triangle, (0,0), (0,1), ..., (1,1), ... Owner of diagonal tile (I,I)
+//adds column sums of tile I to sums. Rows are read once per pack of syrk_rows, only columns of the tiles are packed
+template <typename Acc, typename T>
+void syrk_tiles_kernel(const T *x, size_t p, size_t rb, size_t re, size_t first, size_t last,
+                       const Acc *shift, Acc *acc, Acc *sums)
+{
+    size_t tiles = (p + syrk_tile - 1) / syrk_tile;
+    //tile row of the first tile
+    size_t firstRow = 0, rowStart = 0;
+    while(rowStart + tiles - firstRow <= first){
+        rowStart += tiles - firstRow;
+        ++firstRow;
+    }
+    size_t c0 = firstRow * syrk_tile, width = p - c0;
+
+    ScratchScope scope;
+    Acc *a = scope.allocate<Acc>(syrk_rows * width);
+    for(size_t r0 = rb; r0 < re; r0 += syrk_rows){
+        size_t kb = std::min(syrk_rows, re - r0);
+        for(size_t r = 0; r < kb; ++r){
+            const T *row = x + (r0 + r) * p;
+            Acc *packed = a + r * width;
+            for(size_t j = c0; j < p; ++j)
+                packed[j - c0] = shift ? Acc(row[j]) - shift[j] : Acc(row[j]);
+        }
+        size_t ti = firstRow, tj = firstRow + (first - rowStart);
+        for(size_t t = first; t < last; ++t){
+            size_t i0 = ti * syrk_tile, i1 = std::min(i0 + syrk_tile, p);
+            size_t j0 = tj * syrk_tile, j1 = std::min(j0 + syrk_tile, p);
+            for(size_t r = 0; r < kb; ++r){
+                //column j of the matrix is packed[j - c0], i0 and j0 are not less than c0
+                const Acc *packed = a + r * width;
+                for(size_t i = i0; i < i1; ++i){
+                    Acc ai = packed[i - c0];
+                    Acc *out = acc + i * p;
+                    for(size_t j = std::max(j0, i); j < j1; ++j)
+                        out[j] += ai * packed[j - c0];
+                }
+                if(ti == tj)
+                    for(size_t j = i0; j < i1; ++j)
+                        sums[j] += packed[j - c0];
+            }
+            if(++tj == tiles)
+                tj = ++ti;
+        }
+    }
+}
+
+//sum of (x - shift)^T (x - shift) with both triangles and column sums of x - shift;
+//threads own tiles of the upper triangle and add to the result directly. Only if there are fewer
+//tiles than threads, rows are split on strips too, each strip has its own p x p sum within syrk_budget
+inline constexpr size_t syrk_budget = size_t(1) << 25;
+
+template <typename Acc, typename T>
+Matrix<Acc> syrk(const Matrix<T> &x, const Acc *shift, std::vector<Acc> &sums)
+{
+    size_t n = x.rows(), p = x.columns();
+    size_t tiles = (p + syrk_tile - 1) / syrk_tile;
+    size_t pairs = tiles * (tiles + 1) / 2;
+    size_t strips = 1;
+    if(pairs && pairs < hardware_threads())
+        strips = std::max<size_t>(1, std::min({hardware_threads() / pairs, n / parallel_grain(p * (p + 1) / 2),
+                                               syrk_budget / (p * p * sizeof(Acc))}));
+
+    Matrix<Acc> res(p, p, Acc());
+    std::vector<std::vector<Acc>> partial(strips - 1, std::vector<Acc>(p * p));
+    std::vector<std::vector<Acc>> partialSums(strips, std::vector<Acc>(p));
+    size_t rowsPerStrip = (n + strips - 1) / strips;
+    parallel_for(0, strips * pairs, parallel_grain(rowsPerStrip * syrk_tile * syrk_tile / 2), [&](size_t b, size_t e){
+        //range may cross strips
+        while(b < e){
+            size_t s = b / pairs, last = std::min(e, (s + 1) * pairs);
+            Acc *acc = s ? partial[s - 1].data() : res.data();
+            syrk_tiles_kernel(x.data(), p, s * n / strips, (s + 1) * n / strips, b - s * pairs, last - s * pairs,
+                              shift, acc, partialSums[s].data());
+            b = last;
+        }
+    });
+
+    sums.assign(p, Acc());
+    for(auto &strip: partialSums)
+        for(size_t j = 0; j < p; ++j)
+            sums[j] += strip[j];
+    for(auto &strip: partial)
+        for(size_t i = 0; i < p; ++i)
+            for(size_t j = i; j < p; ++j)
+                res(i, j) += strip[i * p + j];
+    for(size_t i = 0; i < p; ++i)
+        for(size_t j = 0; j < i; ++j)
+            res(i, j) = res(j, i);
+    return res;
+}
+
+//co-moments of columns: sum (x_i - mean_i)(x_j - mean_j); data are shifted by the first row,
+//which is close to means, so correction by column sums does not cancel digits
+template <typename R, typename T>
+Matrix<R> comoments(const Matrix<T> &x)
+{
+    size_t n = x.rows(), p = x.columns();
+    if(n == 0)
+        throw std::length_error("matrix is empty");
+    std::vector<R> shift(x.data(), x.data() + p);
+    std::vector<R> sums;
+    auto res = syrk<R>(x, shift.data(), sums);
+    for(size_t i = 0; i < p; ++i)
+        for(size_t j = 0; j < p; ++j)
+            res(i, j) -= sums[i] * sums[j] / R(n);
+    return res;
+}
+}
+
+//================================================================================================
+//===================================gram and covariance==========================================
+//================================================================================================
+template <typename T>
+Matrix<type_is_t<T>> gram(const Matrix<T>& x)
+{
+    const auto& m = detail::dense(x);
+    std::vector<type_is_t<T>> sums;
+    return detail::syrk<type_is_t<T>>(m, static_cast<const type_is_t<T>*>(nullptr), sums);
+}
+
+template <typename T>
+Matrix<real_type_t<T>> covariance(const Matrix<T>& x, size_t ddof)
+{
+    const auto& m = detail::dense(x);
+    if(m.rows() <= ddof)
+        throw std::length_error("matrix is empty");
+    auto res = detail::comoments<real_type_t<T>>(m);
+    res /= real_type_t<T>(m.rows() - ddof);
+    return res;
+}
+
+template <typename T>
+Matrix<real_type_t<T>> correlation(const Matrix<T>& x)
+{
+    using R = real_type_t<T>;
+    auto res = detail::comoments<R>(detail::dense(x));
+    size_t p = res.columns();
+    std::vector<R> variance(p);
+    for(size_t i = 0; i < p; ++i)
+        variance[i] = res(i, i);
+    //column with zero variance gives NaN, like 0 / 0
+    for(size_t i = 0; i < p; ++i)
+        for(size_t j = 0; j < p; ++j)
+            res(i, j) = i == j && variance[i] > R() ? R(1) : res(i, j) / std::sqrt(variance[i] * variance[j]);
+    return res;
+}
+
+}
+#endif // GRAM_H
@@ -65,6 +65,10 @@ inline constexpr bool is_reference_wrapper_v = is_reference_wrapper<T>::value;
 template <typename T>
 using type_is_t = typename type_is<T>::type;
 
+//floating type for results of mean, norm etc.
+template <typename T>
+using real_type_t = std::conditional_t<std::is_floating_point_v<type_is_t<T>>, type_is_t<T>, double>;
+
 //---------------------Helper arithmetic function----------------
 template <typename Tp, typename U>
 inline std::enable_if_t<is_reference_wrapper_v<Tp>> equal(Tp& t, const U& u)
@@ -102,5 +106,18 @@ inline void multiplies(Tp& t,const U& u)
     t*=u;
 }
 
+namespace detail{
+//independent accumulators, compiler maps them on SIMD registers
+inline constexpr size_t simd_lanes = 8;
+
+//matrix can be broadcast to rows x columns
+template <typename T>
+bool broadcastable(const Matrix<T>& matrix, size_t rows, size_t columns)
+{
+    return (matrix.rows() == rows || matrix.rows() == 1) &&
+           (matrix.columns() == columns || matrix.columns() == 1);
+}
+}
+
 }
 #endif // HELPER_H
@@ -0,0 +1,277 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//=========================================LU kernels=============================================
+//================================================================================================
+template <typename T>
+struct lu_result{
+    std::vector<T> lu;
+    std::vector<size_t> perm;
+    //log |det| and sign of det
+    T logDet = 0;
+    int sign = 1;
+};
+
+//PA = LU with partial pivoting, L has unit diagonal, both are stored in lu,
+//rows below pivot are eliminated in parallel
+template <typename T>
+lu_result<T> lu_factor(const T *a, size_t n)
+{
+    lu_result<T> r{std::vector<T>(a, a + n * n), std::vector<size_t>(n)};
+    for(size_t i = 0; i < n; ++i)
+        r.perm[i] = i;
+    T *lu = r.lu.data();
+    for(size_t c = 0; c < n; ++c){
+        size_t pivot = c;
+        for(size_t i = c + 1; i < n; ++i)
+            if(std::fabs(lu[i * n + c]) > std::fabs(lu[pivot * n + c]))
+                pivot = i;
+        if(lu[pivot * n + c] == T())
+            throw std::runtime_error("matrix is singular");
+        if(pivot != c){
+            std::swap_ranges(lu + pivot * n, lu + pivot * n + n, lu + c * n);
+            std::swap(r.perm[pivot], r.perm[c]);
+            r.sign = -r.sign;
+        }
+        const T *row = lu + c * n;
+        r.logDet += std::log(std::fabs(row[c]));
+        if(row[c] < T())
+            r.sign = -r.sign;
+        parallel_for(c + 1, n, parallel_grain(n - c), [&](size_t b, size_t e){
+            for(size_t i = b; i < e; ++i){
+                T *ri = lu + i * n;
+                T factor = ri[c] / row[c];
+                ri[c] = factor;
+                for(size_t j = c + 1; j < n; ++j)
+                    ri[j] -= factor * row[j];
+            }
+        });
+    }
+    return r;
+}
+
+//inverse from LU, columns of inverse are solved in parallel
+template <typename T>
+void lu_inverse(const lu_result<T> &r, size_t n, T *out)
+{
+    const T *lu = r.lu.data();
+    parallel_for(0, n, parallel_grain(n * n), [&](size_t b, size_t e){
+        std::vector<T> x(n);
+        for(size_t j = b; j < e; ++j){
+            //L y = P e_j
+            for(size_t i = 0; i < n; ++i){
+                T sum = r.perm[i] == j ? T(1) : T();
+                for(size_t k = 0; k < i; ++k)
+                    sum -= lu[i * n + k] * x[k];
+                x[i] = sum;
+            }
+            //U x = y
+            for(size_t i = n; i-- > 0;){
+                T sum = x[i];
+                for(size_t k = i + 1; k < n; ++k)
+                    sum -= lu[i * n + k] * x[k];
+                x[i] = sum / lu[i * n + i];
+            }
+            for(size_t i = 0; i < n; ++i)
+                out[i * n + j] = x[i];
+        }
+    });
+}
+
+//update of rank k: n x k column factor, k = 1 for a vector of length n
+template <typename T>
+Matrix<T> update_factor(const Matrix<T> &x, size_t n)
+{
+    if(x.rows() == n)
+        return x;
+    if(x.rows() == 1 && x.columns() == n){
+        Matrix<T> column(n, 1);
+        std::copy(x.data(), x.data() + n, column.data());
+        return column;
+    }
+    throw std::length_error("Inner matrix dimensions must agree");
+}
+}
+
+//================================================================================================
+//=====================================IncrementalInverse=========================================
+//================================================================================================
+//inverse and log-determinant of square matrix A, which are kept up to date through low rank
+//updates A += U V^T in O(n^2 k) by Sherman-Morrison (k = 1) or Woodbury formulas;
+//after refactorInterval updates inverse is recomputed from A to limit drift, 0 disables it
+template <typename T>
+class IncrementalInverse{
+public:
+    static_assert(std::is_floating_point_v<T>, "IncrementalInverse requires floating-point type");
+
+    explicit IncrementalInverse(const Matrix<T> &a, size_t refactorInterval_ = 64);
+
+    //A += u v^T, u and v are n x k matrices or vectors of length n
+    void update(const Matrix<T> &u, const Matrix<T> &v);
+    //recomputes inverse and determinant from A
+    void refactorize();
+
+    const Matrix<T> &matrix() const;
+    const Matrix<T> &inverse() const;
+    //log |det A| and sign of det A
+    T log_det() const;
+    int sign() const;
+    T det() const;
+
+    size_t refactor_interval() const;
+    void set_refactor_interval(size_t interval);
+    //updates since last refactorization
+    size_t updates() const;
+
+private:
+    void rank1(const Matrix<T> &u, const Matrix<T> &v);
+    void rankk(const Matrix<T> &u, const Matrix<T> &v);
+
+    Matrix<T> a;
+    Matrix<T> inv;
+    T logDet = 0;
+    int detSign = 1;
+    size_t refactorInterval;
+    size_t count = 0;
+};
+
+template <typename T>
+IncrementalInverse<T>::IncrementalInverse(const Matrix<T> &a_, size_t refactorInterval_):
+    a(a_), inv(a_.rows(), a_.columns()), refactorInterval(refactorInterval_)
+{
+    if(a.rows() != a.columns())
+        throw std::length_error("matrix must be square");
+    refactorize();
+}
+
+template <typename T>
+void IncrementalInverse<T>::refactorize()
+{
+    size_t n = a.rows();
+    auto r = detail::lu_factor(a.data(), n);
+    detail::lu_inverse(r, n, inv.data());
+    logDet = r.logDet;
+    detSign = r.sign;
+    count = 0;
+}
+
+template <typename T>
+void IncrementalInverse<T>::update(const Matrix<T> &u, const Matrix<T> &v)
+{
+    size_t n = a.rows();
+    auto uf = detail::update_factor(u, n);
+    auto vf = detail::update_factor(v, n);
+    if(uf.columns() != vf.columns())
+        throw std::runtime_error("Matrix dimensions must agree");
+    if(uf.columns() == 0)
+        return;
+    if(uf.columns() == 1)
+        rank1(uf, vf);
+    else
+        rankk(uf, vf);
+    if(++count >= refactorInterval && refactorInterval)
+        refactorize();
+}
+
+//(A + u v^T)^-1 = A^-1 - (A^-1 u)(v^T A^-1) / (1 + v^T A^-1 u)
+template <typename T>
+void IncrementalInverse<T>::rank1(const Matrix<T> &u, const Matrix<T> &v)
+{
+    size_t n = a.rows();
+    Matrix<T> w(n, 1), z(n, 1);
+    detail::gemv(T(1), detail::view(std::as_const(inv)), u.data(), T(), w.data());
+    detail::gemv_transposed(T(1), detail::view(std::as_const(inv)), v.data(), T(), z.data());
+    T denominator = T(1) + detail::dot_kernel(v.data(), w.data(), n);
+    if(denominator == T())
+        throw std::runtime_error("matrix is singular");
+    detail::rank1_update(detail::view(inv), T(-1) / denominator, w.data(), z.data());
+    detail::rank1_update(detail::view(a), T(1), u.data(), v.data());
+    logDet += std::log(std::fabs(denominator));
+    if(denominator < T())
+        detSign = -detSign;
+}
+
+//(A + U V^T)^-1 = A^-1 - W C^-1 Z, W = A^-1 U, Z = V^T A^-1, C = I + V^T W
+template <typename T>
+void IncrementalInverse<T>::rankk(const Matrix<T> &u, const Matrix<T> &v)
+{
+    size_t k = u.columns();
+    Matrix<T> vt = v;
+    vt.transpose();
+    auto w = inv.dot(u);
+    auto z = vt.dot(inv);
+    auto c = vt.dot(w);
+    for(size_t i = 0; i < k; ++i)
+        c(i, i) += T(1);
+    auto r = detail::lu_factor(c.data(), k);
+    Matrix<T> cinv(k, k);
+    detail::lu_inverse(r, k, cinv.data());
+    //inv -= W (C^-1 Z), a -= -U V^T, both accumulate into existing storage
+    auto y = cinv.dot(z);
+    w *= T(-1);
+    detail::gemm(detail::view(std::as_const(w)), detail::view(std::as_const(y)), detail::view(inv), true);
+    detail::gemm(detail::view(u), detail::view(std::as_const(vt)), detail::view(a), true);
+    logDet += r.logDet;
+    detSign *= r.sign;
+}
+
+template <typename T>
+const Matrix<T> &IncrementalInverse<T>::matrix() const
+{
+    return a;
+}
+
+template <typename T>
+const Matrix<T> &IncrementalInverse<T>::inverse() const
+{
+    return inv;
+}
+
+template <typename T>
+T IncrementalInverse<T>::log_det() const
+{
+    return logDet;
+}
+
+template <typename T>
+int IncrementalInverse<T>::sign() const
+{
+    return detSign;
+}
+
+template <typename T>
+T IncrementalInverse<T>::det() const
+{
+    return T(detSign) * std::exp(logDet);
+}
+
+template <typename T>
+size_t IncrementalInverse<T>::refactor_interval() const
+{
+    return refactorInterval;
+}
+
+template <typename T>
+void IncrementalInverse<T>::set_refactor_interval(size_t interval)
+{
+    refactorInterval = interval;
+}
+
+template <typename T>
+size_t IncrementalInverse<T>::updates() const
+{
+    return count;
+}
+
+}
+#endif // INCREMENTAL_H
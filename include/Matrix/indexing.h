@@ -0,0 +1,151 @@
+#ifndef INDEXING_H
+#define INDEXING_H
+
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//======================================gather kernels============================================
+//================================================================================================
+//rows ahead of the current one, which are prefetched
+inline constexpr size_t prefetch_rows = 2;
+
+inline void prefetch(const void *p, size_t bytes)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    const char *c = static_cast<const char*>(p);
+    for(size_t offset = 0; offset < bytes; offset += 64)
+        __builtin_prefetch(c + offset);
+#else
+    (void)p;
+    (void)bytes;
+#endif
+}
+
+inline void check_indices(const std::vector<size_t> &indices, size_t size)
+{
+    for(auto i: indices)
+        if(i >= size)
+            throw std::out_of_range("Index exceeds matrix dimensions.");
+}
+
+//dst[j] = src[j], j < n, memcpy for dense elements of the same type
+template <typename T, typename U>
+void copy_elements(T *dst, const U *src, size_t n)
+{
+    if constexpr(std::is_same_v<T, U> && !is_reference_wrapper_v<T>)
+        std::memcpy(dst, src, n * sizeof(T));
+    else
+        for(size_t j = 0; j < n; ++j)
+            equal(dst[j], unwrap(src[j]));
+}
+
+//out row k = row indices[k] of src, runs of consecutive indices are copied at once
+template <typename T, typename U>
+void gather_rows(T *out, const U *src, size_t columns, const std::vector<size_t> &indices)
+{
+    parallel_for(0, indices.size(), parallel_grain(columns), [&](size_t b, size_t e){
+        for(size_t k = b; k < e;){
+            size_t run = 1;
+            while(k + run < e && indices[k + run] == indices[k] + run)
+                ++run;
+            if(k + run + prefetch_rows - 1 < e)
+                for(size_t ahead = 0; ahead < prefetch_rows; ++ahead)
+                    prefetch(src + indices[k + run + ahead] * columns, columns * sizeof(U));
+            copy_elements(out + k * columns, src + indices[k] * columns, run * columns);
+            k += run;
+        }
+    });
+}
+
+//runs of consecutive column indices: (source column, output column, length)
+struct index_run{
+    size_t source;
+    size_t target;
+    size_t length;
+};
+
+inline std::vector<index_run> index_runs(const std::vector<size_t> &indices)
+{
+    std::vector<index_run> runs;
+    for(size_t k = 0; k < indices.size(); ++k){
+        if(!runs.empty() && runs.back().source + runs.back().length == indices[k])
+            ++runs.back().length;
+        else
+            runs.push_back({indices[k], k, 1});
+    }
+    return runs;
+}
+}
+
+//================================================================================================
+//==================================gather and scatter============================================
+//================================================================================================
+template <typename T>
+Matrix<type_is_t<T>> take_rows(const Matrix<T>& matrix, const std::vector<size_t>& indices)
+{
+    detail::check_indices(indices, matrix.rows());
+    Matrix<type_is_t<T>> res(indices.size(), matrix.columns());
+    detail::gather_rows(res.data(), matrix.data(), matrix.columns(), indices);
+    return res;
+}
+
+template <typename T>
+Matrix<type_is_t<T>> take_cols(const Matrix<T>& matrix, const std::vector<size_t>& indices)
+{
+    detail::check_indices(indices, matrix.columns());
+    Matrix<type_is_t<T>> res(matrix.rows(), indices.size());
+    auto runs = detail::index_runs(indices);
+    size_t columns = matrix.columns(), taken = indices.size();
+    type_is_t<T> *out = res.data();
+    const T *src = matrix.data();
+    detail::parallel_for(0, matrix.rows(), detail::parallel_grain(taken), [&](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i){
+            if(i + 1 < e)
+                detail::prefetch(src + (i + 1) * columns, columns * sizeof(T));
+            for(auto &run: runs)
+                detail::copy_elements(out + i * taken + run.target, src + i * columns + run.source, run.length);
+        }
+    });
+    return res;
+}
+
+template <typename T, typename U>
+void put_rows(Matrix<T>& matrix, const std::vector<size_t>& indices, const Matrix<U>& rows)
+{
+    if(rows.rows() != indices.size() || rows.columns() != matrix.columns())
+        throw std::runtime_error("Matrix dimensions must agree");
+    detail::check_indices(indices, matrix.rows());
+    //repeated index takes the last row, so such scatter runs serially
+    std::vector<bool> seen(matrix.rows());
+    bool repeated = false;
+    for(auto i: indices){
+        repeated = repeated || seen[i];
+        seen[i] = true;
+    }
+
+    size_t columns = matrix.columns();
+    T *dst = matrix.data();
+    const U *src = rows.data();
+    auto scatter = [&](size_t b, size_t e){
+        for(size_t k = b; k < e;){
+            size_t run = 1;
+            while(k + run < e && indices[k + run] == indices[k] + run)
+                ++run;
+            detail::copy_elements(dst + indices[k] * columns, src + k * columns, run * columns);
+            k += run;
+        }
+    };
+    if(repeated)
+        scatter(0, indices.size());
+    else
+        detail::parallel_for(0, indices.size(), detail::parallel_grain(columns), scatter);
+}
+
+}
+#endif // INDEXING_H
@@ -0,0 +1,142 @@
+#ifndef MAP_H
+#define MAP_H
+
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//========================================map kernels=============================================
+//================================================================================================
+template <typename T>
+inline const T &unwrap(const T &t)
+{
+    return t;
+}
+
+template <typename T>
+inline T &unwrap(const std::reference_wrapper<T> &t)
+{
+    return t.get();
+}
+
+template <typename... Ts>
+void check_shapes([[maybe_unused]] size_t rows, [[maybe_unused]] size_t columns, const Matrix<Ts>&... matrices)
+{
+    if(((matrices.rows() != rows || matrices.columns() != columns) || ...))
+        throw std::runtime_error("Matrix dimensions must agree");
+}
+
+//out[i] = func(in[i]...), out may be one of inputs, blocks of elements run in parallel
+template <typename R, typename Function, typename... Ts>
+void map_kernel(R *out, size_t n, Function func, const Ts*... in)
+{
+    parallel_for(0, n, parallel_threshold, [&](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i){
+            if constexpr(is_reference_wrapper_v<R>)
+                out[i].get() = func(unwrap(in[i])...);
+            else
+                out[i] = func(unwrap(in[i])...);
+        }
+    });
+}
+
+//reduction of map(i) for i in [b, e) by simd_lanes independent accumulators, e - b > 0
+template <typename Acc, typename Map, typename Reduce>
+Acc map_reduce_block(size_t b, size_t e, Map map, Reduce reduce)
+{
+    if(e - b < 2 * simd_lanes){
+        Acc acc = map(b);
+        for(size_t i = b + 1; i < e; ++i)
+            acc = reduce(acc, map(i));
+        return acc;
+    }
+    Acc lanes[simd_lanes];
+    for(size_t l = 0; l < simd_lanes; ++l)
+        lanes[l] = map(b + l);
+    size_t i = b + simd_lanes;
+    for(; i + simd_lanes <= e; i += simd_lanes)
+        for(size_t l = 0; l < simd_lanes; ++l)
+            lanes[l] = reduce(lanes[l], map(i + l));
+    for(size_t l = 0; i < e; ++i, ++l)
+        lanes[l] = reduce(lanes[l], map(i));
+    for(size_t l = 1; l < simd_lanes; ++l)
+        lanes[0] = reduce(lanes[0], lanes[l]);
+    return lanes[0];
+}
+
+//integer power, unrolled at compile time
+template <int N, typename T>
+constexpr T ipow(T x)
+{
+    if constexpr(N < 0)
+        return T(1) / ipow<-N>(x);
+    else if constexpr(N == 0)
+        return T(1);
+    else if constexpr(N == 1)
+        return x;
+    else if constexpr(N % 2 == 0){
+        T half = ipow<N / 2>(x);
+        return half * half;
+    }
+    else
+        return x * ipow<N - 1>(x);
+}
+}
+
+//================================================================================================
+//===========================================map==================================================
+//================================================================================================
+template <typename Function, typename T, typename... Ts>
+auto map(Function func, const Matrix<T>& matrix, const Matrix<Ts>&... rest)
+    -> Matrix<std::decay_t<std::invoke_result_t<Function, type_is_t<T>, type_is_t<Ts>...>>>
+{
+    using R = std::decay_t<std::invoke_result_t<Function, type_is_t<T>, type_is_t<Ts>...>>;
+    Matrix<R> out(matrix.rows(), matrix.columns());
+    map_to(out, func, matrix, rest...);
+    return out;
+}
+
+template <typename R, typename Function, typename T, typename... Ts>
+Matrix<R>& map_to(Matrix<R>& out, Function func, const Matrix<T>& matrix, const Matrix<Ts>&... rest)
+{
+    detail::check_shapes(out.rows(), out.columns(), matrix, rest...);
+    detail::map_kernel(out.data(), out.rows() * out.columns(), func, matrix.data(), rest.data()...);
+    return out;
+}
+
+template <typename Function, typename T, typename U>
+auto zip_with(Function func, const Matrix<T>& t, const Matrix<U>& u)
+{
+    return map(func, t, u);
+}
+
+template <typename Acc, typename Map, typename Reduce, typename T, typename... Ts>
+Acc map_reduce(Map map, Reduce reduce, Acc init, const Matrix<T>& matrix, const Matrix<Ts>&... rest)
+{
+    detail::check_shapes(matrix.rows(), matrix.columns(), rest...);
+    size_t n = matrix.rows() * matrix.columns();
+    auto element = [map, p = std::make_tuple(matrix.data(), rest.data()...)](size_t i) -> Acc {
+        return std::apply([&](const auto*... in){ return map(detail::unwrap(in[i])...); }, p);
+    };
+    auto partial = detail::reduce_blocks<Acc>(n, [&](size_t b, size_t e){
+        return detail::map_reduce_block<Acc>(b, e, element, reduce);
+    });
+    for(auto &value: partial)
+        init = reduce(init, value);
+    return init;
+}
+
+template <int N, typename T>
+Matrix<type_is_t<T>> pow(const Matrix<T>& matrix)
+{
+    Matrix<type_is_t<T>> out(matrix.rows(), matrix.columns());
+    return map_to(out, [](type_is_t<T> x){ return detail::ipow<N>(x); }, matrix);
+}
+
+}
+#endif // MAP_H
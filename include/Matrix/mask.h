@@ -0,0 +1,476 @@
+#ifndef MASK_H
+#define MASK_H
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace matrix_view {
+
+//boolean matrix, 1 bit per element in row-major order, unused bits of the last word are 0
+class MatrixMask{
+public:
+    MatrixMask();
+    MatrixMask(size_t amountRows_, size_t amountColumns_, bool value = false);
+
+    size_t rows() const;
+    size_t columns() const;
+
+    bool operator()(size_t i, size_t j) const;
+    void set(size_t i, size_t j, bool value);
+
+    //words of 64 elements
+    uint64_t *words();
+    const uint64_t *words() const;
+    size_t amount_words() const;
+
+    MatrixMask &operator&=(const MatrixMask &other);
+    MatrixMask &operator|=(const MatrixMask &other);
+    MatrixMask &operator^=(const MatrixMask &other);
+    bool operator==(const MatrixMask &other) const;
+    bool operator!=(const MatrixMask &other) const;
+
+private:
+    template <typename Operation>
+    MatrixMask &combine(const MatrixMask &other, Operation oper);
+    void clear_padding();
+
+    std::vector<uint64_t> bits;
+    size_t amountRows;
+    size_t amountColumns;
+
+    friend MatrixMask operator~(const MatrixMask &mask);
+};
+
+//elements of matrix selected by mask: m[mask] = value
+template <typename T>
+class MaskedView{
+public:
+    MaskedView(Matrix<T> &matrix_, MatrixMask mask_);
+
+    template <typename U>
+    std::enable_if_t<std::is_arithmetic_v<U>, MaskedView&> operator=(const U &value);
+    //elements of other with the same index, other has the same shape
+    template <typename U>
+    MaskedView &operator=(const Matrix<U> &other);
+
+    //selected elements in row-major order, 1xN
+    Matrix<type_is_t<T>> values() const;
+
+private:
+    template <typename Function>
+    void for_each(Function func) const;
+
+    Matrix<T> &matrix;
+    MatrixMask mask;
+};
+
+inline MatrixMask operator&(const MatrixMask &l, const MatrixMask &r);
+inline MatrixMask operator|(const MatrixMask &l, const MatrixMask &r);
+inline MatrixMask operator^(const MatrixMask &l, const MatrixMask &r);
+inline MatrixMask operator~(const MatrixMask &mask);
+
+inline bool any(const MatrixMask &mask);
+inline bool all(const MatrixMask &mask);
+inline size_t count(const MatrixMask &mask);
+
+//element-wise comparisons of matrices of the same shape or of matrix and number
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> operator<(const T &t, const U &u);
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> operator<=(const T &t, const U &u);
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> operator>(const T &t, const U &u);
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> operator>=(const T &t, const U &u);
+//operator== compares whole matrices, these compare elements
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> equal_to(const T &t, const U &u);
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> not_equal_to(const T &t, const U &u);
+
+//|t - u| <= atol + rtol * |u|
+template <typename T, typename U>
+MatrixMask isclose(const Matrix<T> &t, const Matrix<U> &u, double rtol = 1e-5, double atol = 1e-8);
+template <typename T, typename U>
+bool allclose(const Matrix<T> &t, const Matrix<U> &u, double rtol = 1e-5, double atol = 1e-8);
+
+//mask ? a : b, a and b are matrices of shape of mask or numbers
+template <typename T, typename U>
+auto where(const MatrixMask &mask, const T &a, const U &b)
+    -> Matrix<type_is_t<std::conditional_t<is_matrix_v<T>, T, U>>>;
+
+namespace detail{
+//================================================================================================
+//=======================================mask kernels=============================================
+//================================================================================================
+inline constexpr size_t mask_word = 64;
+
+inline size_t popcount(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return size_t(__builtin_popcountll(word));
+#else
+    size_t n = 0;
+    for(; word; word &= word - 1)
+        ++n;
+    return n;
+#endif
+}
+
+//index of the lowest set bit, word != 0
+inline size_t lowest_bit(uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return size_t(__builtin_ctzll(word));
+#else
+    size_t bit = 0;
+    while(!((word >> bit) & 1))
+        ++bit;
+    return bit;
+#endif
+}
+
+//bit i of mask = pred(i), words are built in parallel
+template <typename Predicate>
+void fill_mask(MatrixMask &mask, Predicate pred)
+{
+    size_t n = mask.rows() * mask.columns();
+    uint64_t *words = mask.words();
+    parallel_for(0, mask.amount_words(), parallel_grain(mask_word), [&](size_t b, size_t e){
+        for(size_t w = b; w < e; ++w){
+            size_t first = w * mask_word, bits = std::min(mask_word, n - first);
+            uint64_t word = 0;
+            for(size_t bit = 0; bit < bits; ++bit)
+                word |= uint64_t(pred(first + bit)) << bit;
+            words[w] = word;
+        }
+    });
+}
+
+//element i of matrix or number
+template <typename T>
+decltype(auto) mask_operand(const T &t, size_t i)
+{
+    if constexpr(is_matrix_v<T>)
+        return unwrap(t.data()[i]);
+    else
+        return (t);
+}
+
+template <typename T, typename U>
+void check_mask_operands(size_t rows, size_t columns, const T &t, const U &u)
+{
+    if constexpr(is_matrix_v<T>)
+        if(t.rows() != rows || t.columns() != columns)
+            throw std::runtime_error("Matrix dimensions must agree");
+    if constexpr(is_matrix_v<U>)
+        if(u.rows() != rows || u.columns() != columns)
+            throw std::runtime_error("Matrix dimensions must agree");
+}
+
+template <typename T, typename U, typename Compare>
+MatrixMask compare(const T &t, const U &u, Compare comp)
+{
+    const auto &shape = [&]() -> decltype(auto) {
+        if constexpr(is_matrix_v<T>)
+            return (t);
+        else
+            return (u);
+    }();
+    MatrixMask mask(shape.rows(), shape.columns());
+    check_mask_operands(shape.rows(), shape.columns(), t, u);
+    fill_mask(mask, [&](size_t i){ return comp(mask_operand(t, i), mask_operand(u, i)); });
+    return mask;
+}
+}
+
+//================================================================================================
+//=======================================MatrixMask===============================================
+//================================================================================================
+inline MatrixMask::MatrixMask(): amountRows(0), amountColumns(0) {}
+
+inline MatrixMask::MatrixMask(size_t amountRows_, size_t amountColumns_, bool value):
+    bits((amountRows_ * amountColumns_ + detail::mask_word - 1) / detail::mask_word, value ? ~uint64_t(0) : 0),
+    amountRows(amountRows_), amountColumns(amountColumns_)
+{
+    clear_padding();
+}
+
+inline size_t MatrixMask::rows() const
+{
+    return amountRows;
+}
+
+inline size_t MatrixMask::columns() const
+{
+    return amountColumns;
+}
+
+inline bool MatrixMask::operator()(size_t i, size_t j) const
+{
+    if(i >= amountRows || j >= amountColumns)
+        throw std::out_of_range("Index exceeds matrix dimensions.");
+    size_t k = i * amountColumns + j;
+    return (bits[k / detail::mask_word] >> (k % detail::mask_word)) & 1;
+}
+
+inline void MatrixMask::set(size_t i, size_t j, bool value)
+{
+    if(i >= amountRows || j >= amountColumns)
+        throw std::out_of_range("Index exceeds matrix dimensions.");
+    size_t k = i * amountColumns + j;
+    uint64_t bit = uint64_t(1) << (k % detail::mask_word);
+    if(value)
+        bits[k / detail::mask_word] |= bit;
+    else
+        bits[k / detail::mask_word] &= ~bit;
+}
+
+inline uint64_t *MatrixMask::words()
+{
+    return bits.data();
+}
+
+inline const uint64_t *MatrixMask::words() const
+{
+    return bits.data();
+}
+
+inline size_t MatrixMask::amount_words() const
+{
+    return bits.size();
+}
+
+inline void MatrixMask::clear_padding()
+{
+    size_t used = (amountRows * amountColumns) % detail::mask_word;
+    if(used)
+        bits.back() &= (uint64_t(1) << used) - 1;
+}
+
+template <typename Operation>
+MatrixMask &MatrixMask::combine(const MatrixMask &other, Operation oper)
+{
+    if(rows() != other.rows() || columns() != other.columns())
+        throw std::runtime_error("Matrix dimensions must agree");
+    for(size_t w = 0; w < bits.size(); ++w)
+        bits[w] = oper(bits[w], other.bits[w]);
+    return *this;
+}
+
+inline MatrixMask &MatrixMask::operator&=(const MatrixMask &other)
+{
+    return combine(other, std::bit_and<>());
+}
+
+inline MatrixMask &MatrixMask::operator|=(const MatrixMask &other)
+{
+    return combine(other, std::bit_or<>());
+}
+
+inline MatrixMask &MatrixMask::operator^=(const MatrixMask &other)
+{
+    return combine(other, std::bit_xor<>());
+}
+
+inline bool MatrixMask::operator==(const MatrixMask &other) const
+{
+    return rows() == other.rows() && columns() == other.columns() && bits == other.bits;
+}
+
+inline bool MatrixMask::operator!=(const MatrixMask &other) const
+{
+    return !(*this == other);
+}
+
+inline MatrixMask operator&(const MatrixMask &l, const MatrixMask &r)
+{
+    MatrixMask res(l);
+    return res &= r;
+}
+
+inline MatrixMask operator|(const MatrixMask &l, const MatrixMask &r)
+{
+    MatrixMask res(l);
+    return res |= r;
+}
+
+inline MatrixMask operator^(const MatrixMask &l, const MatrixMask &r)
+{
+    MatrixMask res(l);
+    return res ^= r;
+}
+
+inline MatrixMask operator~(const MatrixMask &mask)
+{
+    MatrixMask res(mask);
+    for(auto &word: res.bits)
+        word = ~word;
+    res.clear_padding();
+    return res;
+}
+
+inline bool any(const MatrixMask &mask)
+{
+    uint64_t acc = 0;
+    for(size_t w = 0; w < mask.amount_words(); ++w)
+        acc |= mask.words()[w];
+    return acc != 0;
+}
+
+inline size_t count(const MatrixMask &mask)
+{
+    const uint64_t *words = mask.words();
+    size_t n = 0;
+    for(size_t w = 0; w < mask.amount_words(); ++w)
+        n += detail::popcount(words[w]);
+    return n;
+}
+
+inline bool all(const MatrixMask &mask)
+{
+    return count(mask) == mask.rows() * mask.columns();
+}
+
+//================================================================================================
+//=======================================MaskedView===============================================
+//================================================================================================
+template <typename T>
+MaskedView<T>::MaskedView(Matrix<T> &matrix_, MatrixMask mask_): matrix(matrix_), mask(std::move(mask_))
+{
+    if(matrix.rows() != mask.rows() || matrix.columns() != mask.columns())
+        throw std::runtime_error("Matrix dimensions must agree");
+}
+
+//func(i) for every selected element, empty words are skipped
+template <typename T>
+template <typename Function>
+void MaskedView<T>::for_each(Function func) const
+{
+    const uint64_t *words = mask.words();
+    for(size_t w = 0; w < mask.amount_words(); ++w){
+        for(uint64_t word = words[w]; word; word &= word - 1)
+            func(w * detail::mask_word + detail::lowest_bit(word));
+    }
+}
+
+template <typename T>
+template <typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, MaskedView<T>&> MaskedView<T>::operator=(const U &value)
+{
+    T *p = matrix.data();
+    for_each([p, &value](size_t i){ equal(p[i], value); });
+    return *this;
+}
+
+template <typename T>
+template <typename U>
+MaskedView<T> &MaskedView<T>::operator=(const Matrix<U> &other)
+{
+    if(other.rows() != matrix.rows() || other.columns() != matrix.columns())
+        throw std::runtime_error("Matrix dimensions must agree");
+    T *p = matrix.data();
+    const U *q = other.data();
+    for_each([p, q](size_t i){ equal(p[i], detail::unwrap(q[i])); });
+    return *this;
+}
+
+template <typename T>
+Matrix<type_is_t<T>> MaskedView<T>::values() const
+{
+    Matrix<type_is_t<T>> res(1, count(mask));
+    const T *p = matrix.data();
+    type_is_t<T> *out = res.data();
+    for_each([p, &out](size_t i){ *out++ = detail::unwrap(p[i]); });
+    return res;
+}
+
+template <typename T>
+MaskedView<T> Matrix<T>::operator[](MatrixMask mask)
+{
+    return MaskedView<T>(*this, std::move(mask));
+}
+
+//================================================================================================
+//======================================comparisons===============================================
+//================================================================================================
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> operator<(const T &t, const U &u)
+{
+    return detail::compare(t, u, std::less<>());
+}
+
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> operator<=(const T &t, const U &u)
+{
+    return detail::compare(t, u, std::less_equal<>());
+}
+
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> operator>(const T &t, const U &u)
+{
+    return detail::compare(t, u, std::greater<>());
+}
+
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> operator>=(const T &t, const U &u)
+{
+    return detail::compare(t, u, std::greater_equal<>());
+}
+
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> equal_to(const T &t, const U &u)
+{
+    return detail::compare(t, u, std::equal_to<>());
+}
+
+template <typename T, typename U>
+std::enable_if_t<is_matrix_v<T> || is_matrix_v<U>, MatrixMask> not_equal_to(const T &t, const U &u)
+{
+    return detail::compare(t, u, std::not_equal_to<>());
+}
+
+template <typename T, typename U>
+MatrixMask isclose(const Matrix<T> &t, const Matrix<U> &u, double rtol, double atol)
+{
+    return detail::compare(t, u, [rtol, atol](const auto &x, const auto &y){
+        return std::fabs(double(x) - double(y)) <= atol + rtol * std::fabs(double(y));
+    });
+}
+
+template <typename T, typename U>
+bool allclose(const Matrix<T> &t, const Matrix<U> &u, double rtol, double atol)
+{
+    if(t.rows() != u.rows() || t.columns() != u.columns())
+        return false;
+    return all(isclose(t, u, rtol, atol));
+}
+
+template <typename T, typename U>
+auto where(const MatrixMask &mask, const T &a, const U &b)
+    -> Matrix<type_is_t<std::conditional_t<is_matrix_v<T>, T, U>>>
+{
+    using R = type_is_t<std::conditional_t<is_matrix_v<T>, T, U>>;
+    detail::check_mask_operands(mask.rows(), mask.columns(), a, b);
+    Matrix<R> res(mask.rows(), mask.columns());
+    size_t n = mask.rows() * mask.columns();
+    const uint64_t *words = mask.words();
+    R *out = res.data();
+    detail::parallel_for(0, mask.amount_words(), detail::parallel_grain(detail::mask_word), [&](size_t wb, size_t we){
+        for(size_t w = wb; w < we; ++w){
+            size_t first = w * detail::mask_word, bits = std::min(detail::mask_word, n - first);
+            uint64_t word = words[w];
+            for(size_t bit = 0; bit < bits; ++bit){
+                size_t i = first + bit;
+                out[i] = ((word >> bit) & 1) ? R(detail::mask_operand(a, i)) : R(detail::mask_operand(b, i));
+            }
+        }
+    });
+    return res;
+}
+
+}
+#endif // MASK_H
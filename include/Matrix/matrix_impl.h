@@ -144,6 +144,25 @@ bool MatrixColumnIterator<Matrix, InputIterator>::operator>=(const MatrixColumnI
 {
     return currentIter >= other.currentIter;
 }
+namespace detail{
+//first write of rows x columns buffer by value according to NUMA placement
+template <typename T>
+void numa_fill(T *p, size_t rows, size_t columns, const T &value)
+{
+    size_t n = rows * columns;
+    NumaPlacement placement = numa_placement;
+    if(placement == NumaPlacement::Interleave)
+        numa_interleave(p, n * sizeof(T));
+    if(placement == NumaPlacement::Local || n < parallel_threshold){
+        std::fill(p, p + n, value);
+        return;
+    }
+    parallel_rows(0, rows, parallel_grain(columns), [&](size_t rb, size_t re){
+        std::fill(p + rb * columns, p + re * columns, value);
+    });
+}
+}
+
 //================================================================================================
 //=======================================MATRIX===================================================
 //================================================================================================
@@ -153,9 +172,15 @@ Matrix<T>::Matrix(): amountRows(0), amountColumns(0) {}
 
 template<typename T>
 Matrix<T>::Matrix(size_t amountRows_, size_t amountColumns_, T value):
-    vector(amountRows_*amountColumns_, value), amountRows(amountRows_), amountColumns(amountColumns_)
+    amountRows(amountRows_), amountColumns(amountColumns_)
 {
-
+    if constexpr(is_reference_wrapper_v<T>)
+        vector.assign(amountRows*amountColumns, value);
+    else{
+        //pages are not touched by resize, the first write places them on NUMA nodes
+        vector.resize(amountRows*amountColumns);
+        detail::numa_fill(vector.data(), amountRows, amountColumns, value);
+    }
 }
 
 template<typename T>
@@ -241,6 +266,14 @@ Matrix<T> &Matrix<T>::operator=(Matrix<T> &&other) noexcept
     return *this;
 }
 
+template<typename T>
+void Matrix<T>::swap(Matrix<T> &other) noexcept
+{
+    vector.swap(other.vector);
+    std::swap(amountRows, other.amountRows);
+    std::swap(amountColumns, other.amountColumns);
+}
+
 template<typename T>
 inline size_t Matrix<T>::rows() const
 {
@@ -253,6 +286,122 @@ inline size_t Matrix<T>::columns() const
     return amountColumns;
 }
 
+template<typename T>
+void Matrix<T>::reserve(size_t rows_, size_t columns_)
+{
+    //empty matrix takes columns_, so capacity counts rows of them
+    if(columns_ && amountRows == 0 && vector.empty())
+        amountColumns = columns_;
+    if(columns_ && columns_ != amountColumns)
+        throw std::runtime_error("Matrix dimensions must agree");
+    vector.reserve(rows_ * (columns_ ? columns_ : amountColumns));
+}
+
+template<typename T>
+size_t Matrix<T>::capacity() const
+{
+    return amountColumns ? vector.capacity() / amountColumns : 0;
+}
+
+//rows with columns_ elements are appended: empty matrix takes columns_,
+//storage doubles, so append is O(1) amortized even after exact reserve
+template<typename T>
+void Matrix<T>::prepare_append(size_t columns_, size_t elements)
+{
+    if(amountRows == 0 && vector.empty())
+        amountColumns = columns_;
+    if(columns_ != amountColumns)
+        throw std::runtime_error("Matrix dimensions must agree");
+    if(vector.size() + elements > vector.capacity())
+        vector.reserve(std::max(vector.size() + elements, 2 * vector.capacity()));
+}
+
+//appended rows, which are read from storage of this matrix, would dangle after it grows, so they are copied
+template<typename T>
+template <typename Iterator>
+bool Matrix<T>::stored_here(Iterator first, Iterator last) const
+{
+    std::less<const void*> less;
+    const void* begin = vector.data();
+    const void* end = vector.data() + vector.size();
+    auto inside = [&](const void* p){ return !less(p, begin) && less(p, end); };
+    for(; first != last; ++first){
+        auto&& element = *first;
+        if(inside(std::addressof(element)))
+            return true;
+        if constexpr(is_reference_wrapper_v<std::decay_t<decltype(element)>>)
+            if(inside(std::addressof(element.get())))
+                return true;
+    }
+    return false;
+}
+
+template<typename T>
+void Matrix<T>::append_row(const T* row, size_t n)
+{
+    if constexpr(!is_reference_wrapper_v<T>)
+        if(stored_here(row, row + n)){
+            std::vector<T> copy(row, row + n);
+            append_row(copy.data(), n);
+            return;
+        }
+    prepare_append(n, n);
+    vector.insert(vector.end(), row, row + n);
+    ++amountRows;
+}
+
+template<typename T>
+template <typename Range>
+void Matrix<T>::append_row(const Range& row)
+{
+    auto first = std::begin(row), last = std::end(row);
+    if constexpr(!is_reference_wrapper_v<T>)
+        if(stored_here(first, last)){
+            std::vector<T> copy(first, last);
+            append_row(copy.data(), copy.size());
+            return;
+        }
+    size_t n = size_t(std::distance(first, last));
+    prepare_append(n, n);
+    vector.insert(vector.end(), first, last);
+    ++amountRows;
+}
+
+template<typename T>
+void Matrix<T>::append_row(std::initializer_list<T> row)
+{
+    append_row(row.begin(), row.size());
+}
+
+template<typename T>
+template <typename U>
+void Matrix<T>::append_rows(const Matrix<U>& other)
+{
+    if constexpr(!is_reference_wrapper_v<T>)
+        if(stored_here(other.begin(), other.end())){
+            append_rows(Matrix<T>(other));
+            return;
+        }
+    prepare_append(other.columns(), other.rows() * other.columns());
+    vector.insert(vector.end(), other.begin(), other.end());
+    amountRows += other.rows();
+}
+
+template<typename T>
+void Matrix<T>::reshape(size_t rows_, size_t columns_)
+{
+    if(rows_ * columns_ != vector.size())
+        throw std::runtime_error("Matrix dimensions must agree");
+    amountRows = rows_;
+    amountColumns = columns_;
+}
+
+template<typename T>
+void Matrix<T>::shrink_to_fit()
+{
+    vector.shrink_to_fit();
+}
+
 template<typename T>
 decltype(auto) Matrix<T>::operator()(size_t i, size_t j) const
 {
@@ -289,7 +438,10 @@ decltype (auto) Matrix<T>::operator()(const std::string& range) const
     //parse range columns
     parseSliceExpression(range.substr(comma + 1), rangeCol1, rangeCol2, amountColumns);
 
-    std::vector<std::reference_wrapper<const type_is_t<T>>> ref_vec;
+    using Ref = std::reference_wrapper<const type_is_t<T>>;
+    ScratchScope scope;
+    std::vector<Ref, detail::scratch_allocator<Ref>> ref_vec{detail::scratch_allocator<Ref>(scope.get())};
+    ref_vec.reserve((rangeRow2 - rangeRow1) * (rangeCol2 - rangeCol1));
     for(auto i = rangeRow1; i < rangeRow2; i++)
         for(auto j = rangeCol1; j < rangeCol2; j++)
             ref_vec.push_back((*this)(i,j));
@@ -303,8 +455,10 @@ decltype (auto) Matrix<T>::operator()(const std::string& range)
 {
 
     auto m_const = static_cast<const Matrix<T>&>(*this)(range);
-    std::vector<std::reference_wrapper<type_is_t<T>>> vec;
-
+    using Ref = std::reference_wrapper<type_is_t<T>>;
+    ScratchScope scope;
+    std::vector<Ref, detail::scratch_allocator<Ref>> vec{detail::scratch_allocator<Ref>(scope.get())};
+    vec.reserve(m_const.rows() * m_const.columns());
     for(auto it = m_const.begin(); it != m_const.end(); ++it){
         vec.push_back(const_cast<type_is_t<T>&>((*it).get()));
     }
@@ -420,64 +574,80 @@ auto Matrix<T>::cend_column(size_t n) const
 }
 
 template<typename T>
-T Matrix<T>::det() const {
-    T det = 0;
-    int degree = 1;
-    if(amountRows != amountColumns)
-        throw std::length_error("matrix must be square");
-    if(amountRows == 1)
-        return (*this)(0,0);
-    if(amountRows == 2)
-        return (*this)(0,0) * (*this)(1,1) - (*this)(0,1) * (*this)(1,0);
-    for(size_t j = 0; j < amountColumns; j++)
-    {
-        Matrix<T> m(amountRows - 1, amountColumns - 1);
-        for(size_t _i = 1; _i< amountRows; _i++){
-            for(size_t _j = 0, t = 0; _j< amountColumns; _j++){
-                if(_j != j)
-                {
-                    m(_i-1,t) = (*this)(_i,_j);
-                    t++;
-                }
-            }
-        }
-        det = det + degree * (*this)(0,j) * m.det();
-        degree = -degree;
-    }
-    return det;
+T* Matrix<T>::data()
+{
+    return vector.data();
+}
+
+template<typename T>
+const T* Matrix<T>::data() const
+{
+    return vector.data();
 }
 
 template<typename T>
-Matrix<T> Matrix<T>::dot(const Matrix &other) const
+Matrix<T> Matrix<T>::dot(const Matrix &other, Product mode) const
 {
     if(amountColumns != other.amountRows)
         throw std::length_error("Inner matrix dimensions must agree");
     Matrix<T> res(amountRows, other.amountColumns);
-    for(size_t i = 0;i< amountRows;i++)
-        for(size_t j = 0;j< other.amountColumns; j++)
-        {
-            T sum = 0;
-            for(size_t k = 0;k < amountColumns;k++)
-            {
-                sum+=(*this)(i,k)*other(k,j);
-            }
-            res(i,j) = sum;
-        }
-
+    detail::block_view<const T> a{data(), amountRows, amountColumns, amountColumns};
+    detail::block_view<const T> b{other.data(), other.amountRows, other.amountColumns, other.amountColumns};
+    detail::block_view<T> c{res.data(), res.amountRows, res.amountColumns, res.amountColumns};
+    if(other.amountColumns == 1)
+        detail::gemv(T(1), a, other.data(), T(), res.data());
+    else if(amountRows == 1)
+        detail::gemv_transposed(T(1), b, data(), T(), res.data());
+    else if(mode == Product::Strassen)
+        detail::strassen(a, b, c);
+    else
+        detail::gemm(a, b, c);
     return res;
 }
 
 template<typename T>
 void Matrix<T>::transpose()
 {
-    std::vector<int> vec(vector);
-    for(size_t i = 0; i < amountRows; ++i){
-        for(size_t j = 0; j < amountColumns; ++j){
-            size_t k = i*amountColumns + j;
-            size_t n = j*amountRows + i;
-            vector[n] = vec[k];
-        }
+    size_t tile = std::max<size_t>(1, detail::transpose_params.tile);
+    size_t rows = amountRows, columns = amountColumns;
+    if(rows == columns){
+        //block row bi swaps its blocks with block column bi, so threads touch disjoint elements
+        size_t blocks = (rows + tile - 1) / tile;
+        detail::parallel_for(0, blocks, detail::parallel_grain(tile * rows), [&](size_t bb, size_t be){
+            for(size_t bi = bb; bi < be; ++bi){
+                size_t i0 = bi * tile, i1 = std::min(i0 + tile, rows);
+                for(size_t j0 = i0; j0 < columns; j0 += tile){
+                    size_t j1 = std::min(j0 + tile, columns);
+                    for(size_t i = i0; i < i1; ++i)
+                        for(size_t j = std::max(j0, i + 1); j < j1; ++j)
+                            std::swap(vector[i*columns + j], vector[j*rows + i]);
+                }
+            }
+        });
+        return;
     }
+    //rows of result are split between threads and filled by tiles
+    auto scatter = [&](const auto &vec){
+        detail::parallel_for(0, (columns + tile - 1) / tile, detail::parallel_grain(tile * rows), [&](size_t bb, size_t be){
+            for(size_t j0 = bb * tile; j0 < std::min(be * tile, columns); j0 += tile){
+                size_t j1 = std::min(j0 + tile, columns);
+                for(size_t i0 = 0; i0 < rows; i0 += tile){
+                    size_t i1 = std::min(i0 + tile, rows);
+                    for(size_t j = j0; j < j1; ++j)
+                        for(size_t i = i0; i < i1; ++i)
+                            vector[j*rows + i] = vec[i*columns + j];
+                }
+            }
+        });
+    };
+    //copy of elements is taken from scratch arena
+    if constexpr(std::is_trivially_destructible_v<T>){
+        ScratchScope scope;
+        scatter(std::vector<T, detail::scratch_allocator<T>>(vector.begin(), vector.end(),
+                                                             detail::scratch_allocator<T>(scope.get())));
+    }
+    else
+        scatter(std::vector<T>(vector.begin(), vector.end()));
     std::swap(amountRows, amountColumns);
 }
 
@@ -487,11 +657,42 @@ Matrix<T> &Matrix<T>::doOperItself(const Item &item, Operation oper)
 {
 
     if constexpr(is_matrix_v<Item>){
-        if(rows() != item.rows() || columns() != item.columns())
+        if(rows() == item.rows() && columns() == item.columns()){
+            auto it = item.begin();
+            for(size_t i = 0; i < vector.size(); ++i)
+                oper(vector[i],*(it++));
+        }
+        else if(detail::broadcastable(item, rows(), columns())){
+            //slice of this matrix would be read after its rows are changed, so it is copied
+            if constexpr(is_reference_wrapper_v<typename Item::value_type> && !is_reference_wrapper_v<T>){
+                std::less<const void*> less;
+                const void* first = vector.data();
+                const void* last = vector.data() + vector.size();
+                for(auto& element: item){
+                    const void* p = &static_cast<const type_is_t<Item>&>(element);
+                    if(!less(p, first) && less(p, last))
+                        return doOperItself(Matrix<type_is_t<Item>>(item), oper);
+                }
+            }
+            //row, column or element of item is taken by step 0
+            auto it = item.begin();
+            size_t rowStep = item.rows() == 1 ? 0 : item.columns();
+            for(size_t i = 0; i < amountRows; ++i){
+                auto row = it + i * rowStep;
+                auto out = vector.begin() + i * amountColumns;
+                if(item.columns() == 1){
+                    const type_is_t<Item>& value = row[0];
+                    for(size_t j = 0; j < amountColumns; ++j)
+                        oper(out[j], value);
+                }
+                else{
+                    for(size_t j = 0; j < amountColumns; ++j)
+                        oper(out[j], row[j]);
+                }
+            }
+        }
+        else
             throw std::runtime_error("Matrix dimensions must agree");
-        auto it = item.begin();
-        for(size_t i = 0; i < vector.size(); ++i)
-            oper(vector[i],*(it++));
     }
     else {
         for(size_t i = 0; i < vector.size(); ++i)
@@ -537,7 +738,7 @@ Matrix<T>& Matrix<T>::operator*=(const Item &item)
 
 template<typename T>
 template <typename Tp>
-bool Matrix<T>::operator==(const Matrix<Tp>& other)
+bool Matrix<T>::operator==(const Matrix<Tp>& other) const
 {
     if(rows() != other.rows() || columns() != other.columns())
         return false;
@@ -555,7 +756,7 @@ bool Matrix<T>::operator==(const Matrix<Tp>& other)
 
 template<typename T>
 template <typename Tp>
-bool Matrix<T>::operator!=(const Matrix<Tp>& other)
+bool Matrix<T>::operator!=(const Matrix<Tp>& other) const
 {
     return !this->operator==(other);
 }
@@ -601,26 +802,65 @@ Matrix<type_is_t<T>> cat(size_t dim,const Matrix<T>& matrix1, const Matrix<U>& m
     if(dim != 1 && dim != 2)
         throw std::logic_error("wrong dimesion");
 
+    //elements are copied to result directly, without temporary
     if(dim == 1){
         if(matrix1.columns() != matrix2.columns())
             throw std::logic_error("cat arguments dimensions are not consistent.");
-        std::vector<type_is_t<T>> vec;
-        std::copy(matrix1.begin(), matrix1.end(), std::back_inserter(vec));
-        std::copy(matrix2.begin(), matrix2.end(), std::back_inserter(vec));
-        return Matrix<type_is_t<T>>(matrix1.rows() + matrix2.rows(), matrix1.columns(),
-                                    vec.begin(), vec.end());
+        Matrix<type_is_t<T>> res(matrix1.rows() + matrix2.rows(), matrix1.columns());
+        auto out = std::copy(matrix1.begin(), matrix1.end(), res.begin());
+        std::copy(matrix2.begin(), matrix2.end(), out);
+        return res;
     }
     else{
         if(matrix1.rows() != matrix2.rows())
             throw std::logic_error("conarguments dimensions are not consistent.");
-        std::vector<type_is_t<T>> vec;
+        Matrix<type_is_t<T>> res(matrix1.rows(), matrix1.columns() + matrix2.columns());
+        auto out = res.begin();
         for(size_t i = 0; i < matrix1.rows(); ++i){
-            std::copy(matrix1.begin_row(i), matrix1.end_row(i), std::back_inserter(vec));
-            std::copy(matrix2.begin_row(i), matrix2.end_row(i), std::back_inserter(vec));
+            out = std::copy(matrix1.begin_row(i), matrix1.end_row(i), out);
+            out = std::copy(matrix2.begin_row(i), matrix2.end_row(i), out);
+        }
+        return res;
+    }
+}
+
+template <typename T, typename U, typename Operation>
+Matrix<type_is_t<T>> broadcast(const Matrix<T>& t, const Matrix<U>& u, Operation oper)
+{
+    using Tp = type_is_t<T>;
+    using Up = type_is_t<U>;
+    size_t rows = std::max(t.rows(), u.rows());
+    size_t columns = std::max(t.columns(), u.columns());
+    if(!detail::broadcastable(t, rows, columns) || !detail::broadcastable(u, rows, columns))
+        throw std::runtime_error("Matrix dimensions must agree");
+
+    Matrix<Tp> res(rows, columns);
+    size_t tRowStep = t.rows() == 1 ? 0 : t.columns();
+    size_t uRowStep = u.rows() == 1 ? 0 : u.columns();
+    bool tRow = t.columns() != 1 || columns == 1;
+    bool uRow = u.columns() != 1 || columns == 1;
+    for(size_t i = 0; i < rows; ++i){
+        auto left = t.begin() + i * tRowStep;
+        auto right = u.begin() + i * uRowStep;
+        auto out = res.begin() + i * columns;
+        if(tRow && uRow){
+            for(size_t j = 0; j < columns; ++j)
+                out[j] = oper(static_cast<const Tp&>(left[j]), static_cast<const Up&>(right[j]));
         }
-        return Matrix<type_is_t<T>>(matrix1.rows(), matrix1.columns() + matrix2.columns(),
-                                    vec.begin(), vec.end());
+        else if(tRow){
+            const Up& value = right[0];
+            for(size_t j = 0; j < columns; ++j)
+                out[j] = oper(static_cast<const Tp&>(left[j]), value);
+        }
+        else if(uRow){
+            const Tp& value = left[0];
+            for(size_t j = 0; j < columns; ++j)
+                out[j] = oper(value, static_cast<const Up&>(right[j]));
+        }
+        else
+            std::fill(out, out + columns, oper(static_cast<const Tp&>(left[0]), static_cast<const Up&>(right[0])));
     }
+    return res;
 }
 
 //do Operation on Matrix(arithmetic Type) and Matrix(arithmetic type)
@@ -628,9 +868,13 @@ Matrix<type_is_t<T>> cat(size_t dim,const Matrix<T>& matrix1, const Matrix<U>& m
 template <typename T, typename U>
 inline std::enable_if_t<is_matrix_v<T>, Matrix<type_is_t<T>>> operator+(T t, U u)
 {
-    Matrix<type_is_t<T>> res(t);
-    res+=u;
-    return res;
+    if constexpr(is_matrix_v<U>)
+        return broadcast(t, u, std::plus<>());
+    else{
+        Matrix<type_is_t<T>> res(t);
+        res+=u;
+        return res;
+    }
 }
 
 template <typename T, typename U>
@@ -645,9 +889,13 @@ inline std::enable_if_t<std::is_arithmetic_v<T> & is_matrix_v<U>,Matrix<type_is_
 template <typename T, typename U>
 inline std::enable_if_t<is_matrix_v<T>, Matrix<type_is_t<T>>> operator-(T t, U u)
 {
-    Matrix<type_is_t<T>> res(t);
-    res-=u;
-    return res;
+    if constexpr(is_matrix_v<U>)
+        return broadcast(t, u, std::minus<>());
+    else{
+        Matrix<type_is_t<T>> res(t);
+        res-=u;
+        return res;
+    }
 }
 
 template <typename T, typename U>
@@ -662,9 +910,13 @@ inline std::enable_if_t<std::is_arithmetic_v<T> & is_matrix_v<U>,Matrix<type_is_
 template <typename T, typename U>
 inline std::enable_if_t<is_matrix_v<T>, Matrix<type_is_t<T>>> operator/(T t, U u)
 {
-    Matrix<type_is_t<T>> res(t);
-    res/=u;
-    return res;
+    if constexpr(is_matrix_v<U>)
+        return broadcast(t, u, std::divides<>());
+    else{
+        Matrix<type_is_t<T>> res(t);
+        res/=u;
+        return res;
+    }
 }
 
 template <typename T, typename U>
@@ -679,9 +931,13 @@ inline std::enable_if_t<std::is_arithmetic_v<T> & is_matrix_v<U>,Matrix<type_is_
 template <typename T, typename U>
 inline std::enable_if_t<is_matrix_v<T>, Matrix<type_is_t<T>>> operator*(T t, U u)
 {
-    Matrix<type_is_t<T>> res(t);
-    res*=u;
-    return res;
+    if constexpr(is_matrix_v<U>)
+        return broadcast(t, u, std::multiplies<>());
+    else{
+        Matrix<type_is_t<T>> res(t);
+        res*=u;
+        return res;
+    }
 }
 
 template <typename T, typename U>
@@ -692,13 +948,117 @@ inline std::enable_if_t<std::is_arithmetic_v<T> & is_matrix_v<U>,Matrix<type_is_
     return res;
 }
 
+namespace detail{
+inline bool is_vector(size_t rows, size_t columns, size_t size)
+{
+    return (rows == 1 || columns == 1) && rows * columns == size;
+}
+
+template <typename T>
+block_view<const T> view(const Matrix<T>& matrix)
+{
+    return {matrix.data(), matrix.rows(), matrix.columns(), matrix.columns()};
+}
+
+template <typename T>
+block_view<T> view(Matrix<T>& matrix)
+{
+    return {matrix.data(), matrix.rows(), matrix.columns(), matrix.columns()};
+}
+}
+
+template <typename T>
+Matrix<T> matrix_power(const Matrix<T>& matrix, unsigned long long k)
+{
+    if(matrix.rows() != matrix.columns())
+        throw std::length_error("matrix must be square");
+    size_t n = matrix.rows();
+    Matrix<T> res(n, n);
+    if(k == 0){
+        for(size_t i = 0; i < n; ++i)
+            res(i, i) = 1;
+        return res;
+    }
+    //res, base and temp are ping-pong buffers, products don't allocate
+    Matrix<T> base(matrix), temp(n, n);
+    std::vector<T> work;
+    bool started = false;
+    while(true){
+        if(k & 1){
+            if(started){
+                detail::product<T>(detail::view(res), detail::view(base), detail::view(temp), work);
+                res.swap(temp);
+            }
+            else
+                std::copy(base.begin(), base.end(), res.begin());
+            started = true;
+        }
+        k >>= 1;
+        if(k == 0)
+            break;
+        detail::product<T>(detail::view(base), detail::view(base), detail::view(temp), work);
+        base.swap(temp);
+    }
+    return res;
+}
+
+template <typename T>
+Matrix<T> matrix_power(const Matrix<T>& matrix, unsigned long long k, const Matrix<T>& vectors)
+{
+    if(matrix.rows() != matrix.columns())
+        throw std::length_error("matrix must be square");
+    if(matrix.columns() != vectors.rows())
+        throw std::length_error("Inner matrix dimensions must agree");
+    //k products with vectors cost k*n*n*b, power costs about 2*log2(k)*n*n*n + n*n*b
+    size_t n = matrix.rows(), b = vectors.columns();
+    double bits = 0;
+    for(auto e = k; e; e >>= 1)
+        ++bits;
+    if(double(k) * b > 2 * bits * n + b)
+        return matrix_power(matrix, k).dot(vectors);
+
+    Matrix<T> res(vectors), temp(n, b);
+    std::vector<T> work;
+    for(unsigned long long i = 0; i < k; ++i){
+        detail::product<T>(detail::view(matrix), detail::view(res), detail::view(temp), work);
+        res.swap(temp);
+    }
+    return res;
+}
+
+template <typename T>
+void gemv(T alpha, const Matrix<T>& a, const Matrix<T>& x, T beta, Matrix<T>& y)
+{
+    if(!detail::is_vector(x.rows(), x.columns(), a.columns()) ||
+       !detail::is_vector(y.rows(), y.columns(), a.rows()))
+        throw std::length_error("Vector dimensions must agree");
+    detail::gemv(alpha, detail::view(a), x.data(), beta, y.data());
+}
+
+template <typename T>
+void gemv_transposed(T alpha, const Matrix<T>& a, const Matrix<T>& x, T beta, Matrix<T>& y)
+{
+    if(!detail::is_vector(x.rows(), x.columns(), a.rows()) ||
+       !detail::is_vector(y.rows(), y.columns(), a.columns()))
+        throw std::length_error("Vector dimensions must agree");
+    detail::gemv_transposed(alpha, detail::view(a), x.data(), beta, y.data());
+}
+
+template <typename T>
+void rank1_update(Matrix<T>& a, T alpha, const Matrix<T>& x, const Matrix<T>& y)
+{
+    if(!detail::is_vector(x.rows(), x.columns(), a.rows()) ||
+       !detail::is_vector(y.rows(), y.columns(), a.columns()))
+        throw std::length_error("Vector dimensions must agree");
+    detail::rank1_update(detail::view(a), alpha, x.data(), y.data());
+}
+
 template <typename T, typename UnaryOperation>
 Matrix<type_is_t<T>> doUnaryOperation(const Matrix<T>& matrix, UnaryOperation oper)
 {
-    std::vector<type_is_t<T>> vec;
-    for(auto it = matrix.begin(); it != matrix.end(); ++it)
-        vec.push_back(oper(*it));
-    return Matrix<type_is_t<T>>(matrix.rows(), matrix.columns(), vec.begin(), vec.end());
+    Matrix<type_is_t<T>> res(matrix.rows(), matrix.columns());
+    map_to(res, oper, matrix);
+    return res;
 }
 
 template <typename T>
@@ -727,14 +1087,9 @@ inline auto atan(const Matrix<T>& matrix)
 template <typename T>
 inline auto atan2(const Matrix<T>& matrix_y, const Matrix<T>& matrix_x)
 {
-    if(matrix_y.rows() != matrix_x.rows() || matrix_y.columns() != matrix_x.item.columns())
-        throw std::runtime_error("Matrix dimensions must agree");
-    std::vector<type_is_t<T>> vec;
-    auto it_y = matrix_y.begin();
-    auto it_x = matrix_x.begin();
-    while(it_y != matrix_y.end())
-        vec.push_back(std::atan2(*(it_y++), *(it_x++)));
-    return Matrix<type_is_t<T>>(matrix_y.rows(), matrix_y.columns(), vec.begin(), vec.end());
+    Matrix<type_is_t<T>> res(matrix_y.rows(), matrix_y.columns());
+    map_to(res, [](type_is_t<T> y, type_is_t<T> x){ return std::atan2(y, x); }, matrix_y, matrix_x);
+    return res;
 }
 
 template <typename T>
@@ -788,26 +1143,19 @@ inline auto floor(const Matrix<T>& matrix)
 template <typename T, typename U>
 inline auto pow(const Matrix<T>& matrix, U up)
 {
-    return doUnaryOperation(matrix,std::bind(std::pow<type_is_t<T>>, std::placeholders::_1, up));
-}
-
-//-----------------Create matrix-------------------
-template <typename T>
-inline Matrix<T> make_random_matrix(size_t rows, size_t columns, int min, int max)
-{
-    //TODO: srand doesn't work, if call this function twice or more times
-    srand(time(0));
-
-    Matrix<T> m(rows, columns);
-
-    for(size_t i = 0; i < rows; i++){
-        for(size_t j = 0; j < columns; j++){
-            m(i, j) = rand() % (max - min) + min;
-        }
+    //small integer exponents are computed by multiplications
+    if constexpr(std::is_arithmetic_v<U>){
+        if(up == U(2))
+            return pow<2>(matrix);
+        if(up == U(3))
+            return pow<3>(matrix);
+        if(up == U(4))
+            return pow<4>(matrix);
     }
-    return m;
+    return doUnaryOperation(matrix, [up](type_is_t<T> x){ return std::pow(x, up); });
 }
 
+//-----------------Create matrix-------------------
 template <typename T>
 inline Matrix<T> make_ones_matrix(size_t rows, size_t columns)
 {
@@ -0,0 +1,238 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace matrix_view{
+
+//placement of pages of matrices built by Matrix(rows, columns, value):
+//Local - all pages on node of constructing thread,
+//Interleave - pages round-robin over all nodes,
+//RowBlocks - rows are split on blocks as in parallel kernels, every block is first touched on its node
+enum class NumaPlacement{Local, Interleave, RowBlocks};
+
+struct NumaReport{
+    //pages[node] - amount of pages of matrix on node
+    std::vector<size_t> pages;
+    //pages, which are not allocated yet or whose node is unknown
+    size_t unknown = 0;
+};
+
+inline void set_numa_placement(NumaPlacement placement);
+//chunks of row-partitioned kernels over RowBlocks matrices (fill, product) run on threads
+//pinned to node of rows of the chunk, other parallel loops are never pinned
+inline void set_thread_pinning(bool enable);
+inline size_t numa_nodes();
+
+template <typename T>
+NumaReport numa_report(const Matrix<T> &matrix);
+inline std::ostream &operator<<(std::ostream &os, const NumaReport &report);
+
+namespace detail{
+inline std::atomic<NumaPlacement> numa_placement{NumaPlacement::RowBlocks};
+inline std::atomic<bool> thread_pinning{true};
+
+//allocator of matrix storage, elements without initializer are default-initialized,
+//so pages of arithmetic types are not touched until first write
+template <typename T>
+struct default_init_allocator: std::allocator<T>{
+    using std::allocator<T>::allocator;
+
+    template <typename U>
+    struct rebind{
+        using other = default_init_allocator<U>;
+    };
+
+    template <typename U>
+    void construct(U *p) noexcept(std::is_nothrow_default_constructible_v<U>)
+    {
+        ::new(static_cast<void*>(p)) U;
+    }
+
+    template <typename U, typename... Args>
+    void construct(U *p, Args&&... args)
+    {
+        ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+//cpus of every node from sysfs, one node with all cpus if there is no NUMA information
+inline const std::vector<std::vector<int>> &numa_topology()
+{
+    static const std::vector<std::vector<int>> topology = [](){
+        std::vector<std::vector<int>> nodes;
+        for(size_t node = 0;; ++node){
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if(!file)
+                break;
+            //list of ranges "0-3,8-11"
+            std::vector<int> cpus;
+            std::string range;
+            while(std::getline(file, range, ',')){
+                int first = 0, last = 0;
+                char dash = 0;
+                std::istringstream stream(range);
+                if(!(stream >> first))
+                    continue;
+                last = first;
+                if(stream >> dash >> last && dash != '-')
+                    last = first;
+                for(int cpu = first; cpu <= last; ++cpu)
+                    cpus.push_back(cpu);
+            }
+            nodes.push_back(std::move(cpus));
+        }
+        if(nodes.empty())
+            nodes.emplace_back();
+        return nodes;
+    }();
+    return topology;
+}
+
+//node of chunk of parallel_for, nodes own equal consecutive parts of rows
+inline size_t chunk_node(size_t chunk, size_t chunks)
+{
+    return chunks ? chunk * numa_topology().size() / chunks : 0;
+}
+
+//pins current thread to cpus of node of the chunk, if pin is set,
+//restores previous affinity on destruction
+class numa_pin{
+public:
+    numa_pin(bool pin, size_t chunk, size_t chunks)
+    {
+        if(!pin || !thread_pinning)
+            return;
+        const auto &topology = numa_topology();
+        if(topology.size() < 2)
+            return;
+        const auto &cpus = topology[chunk_node(chunk, chunks)];
+        if(cpus.empty() || sched_getaffinity(0, sizeof(previous), &previous) != 0)
+            return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(int cpu: cpus)
+            if(cpu < CPU_SETSIZE)
+                CPU_SET(cpu, &set);
+        pinned = sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+    numa_pin(const numa_pin &other) = delete;
+    numa_pin &operator=(const numa_pin &other) = delete;
+    ~numa_pin()
+    {
+        if(pinned)
+            sched_setaffinity(0, sizeof(previous), &previous);
+    }
+
+private:
+    cpu_set_t previous;
+    bool pinned = false;
+};
+
+inline size_t page_size()
+{
+    static const size_t size = size_t(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+//pages, which are inside [p, p + bytes)
+inline bool page_range(const void *p, size_t bytes, uintptr_t &first, size_t &length)
+{
+    uintptr_t begin = reinterpret_cast<uintptr_t>(p), end = begin + bytes;
+    first = (begin + page_size() - 1) / page_size() * page_size();
+    uintptr_t last = end / page_size() * page_size();
+    length = last > first ? last - first : 0;
+    return length > 0;
+}
+
+//interleave policy for untouched pages of buffer, failure keeps default policy
+inline void numa_interleave(void *p, size_t bytes)
+{
+#ifdef SYS_mbind
+    size_t nodes = numa_topology().size();
+    uintptr_t first;
+    size_t length;
+    if(nodes < 2 || !page_range(p, bytes, first, length))
+        return;
+    constexpr int interleave = 3;   //MPOL_INTERLEAVE
+    std::vector<unsigned long> mask((nodes + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long)));
+    for(size_t node = 0; node < nodes; ++node)
+        mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+    syscall(SYS_mbind, first, length, interleave, mask.data(), nodes + 1, 0);
+#else
+    (void)p;
+    (void)bytes;
+#endif
+}
+}
+
+//================================================================================================
+//=========================================NUMA===================================================
+//================================================================================================
+inline void set_numa_placement(NumaPlacement placement)
+{
+    detail::numa_placement = placement;
+}
+
+inline void set_thread_pinning(bool enable)
+{
+    detail::thread_pinning = enable;
+}
+
+inline size_t numa_nodes()
+{
+    return detail::numa_topology().size();
+}
+
+template <typename T>
+NumaReport numa_report(const Matrix<T> &matrix)
+{
+    NumaReport report;
+    report.pages.resize(numa_nodes());
+    size_t bytes = matrix.rows() * matrix.columns() * sizeof(T);
+    if(bytes == 0)
+        return report;
+    //pages, which contain any element of matrix
+    uintptr_t begin = reinterpret_cast<uintptr_t>(matrix.data()) / detail::page_size() * detail::page_size();
+    uintptr_t end = reinterpret_cast<uintptr_t>(matrix.data()) + bytes;
+    std::vector<void*> pages;
+    for(uintptr_t page = begin; page < end; page += detail::page_size())
+        pages.push_back(reinterpret_cast<void*>(page));
+    std::vector<int> status(pages.size(), -1);
+#ifdef SYS_move_pages
+    if(syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+        std::fill(status.begin(), status.end(), -1);
+#endif
+    for(int node: status){
+        if(node >= 0 && size_t(node) < report.pages.size())
+            ++report.pages[size_t(node)];
+        else
+            ++report.unknown;
+    }
+    return report;
+}
+
+inline std::ostream &operator<<(std::ostream &os, const NumaReport &report)
+{
+    for(size_t node = 0; node < report.pages.size(); ++node)
+        os << "node " << node << ": " << report.pages[node] << " pages\n";
+    if(report.unknown)
+        os << "unknown: " << report.unknown << " pages\n";
+    return os;
+}
+
+}
+#endif // NUMA_H
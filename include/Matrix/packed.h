@@ -0,0 +1,625 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace matrix_view {
+
+//================================================================================================
+//=====================================packed matrices============================================
+//================================================================================================
+//symmetric n x n matrix, lower triangle is stored by rows: (i, j), j <= i at i * (i + 1) / 2 + j
+template <typename T>
+class SymmetricMatrix{
+public:
+    static_assert(std::is_arithmetic_v<T>, "Type must be arithmetic");
+
+    explicit SymmetricMatrix(size_t n_ = 0, T value = T());
+    //lower triangle of square matrix
+    template <typename U>
+    static SymmetricMatrix from_matrix(const Matrix<U> &matrix);
+    Matrix<T> to_matrix() const;
+
+    size_t rows() const;
+    size_t columns() const;
+    T operator()(size_t i, size_t j) const;
+    //sets (i, j) and (j, i)
+    void set(size_t i, size_t j, T value);
+
+    //this * other
+    Matrix<T> dot(const Matrix<T> &other) const;
+
+    bool same_structure(const SymmetricMatrix &other) const;
+    std::vector<T> &packed();
+    const std::vector<T> &packed() const;
+
+private:
+    size_t index(size_t i, size_t j) const;
+
+    size_t n;
+    std::vector<T> storage;
+};
+
+enum class Triangle{ Lower, Upper };
+
+//lower (upper) triangular n x n matrix, stored part is packed by rows
+template <typename T>
+class TriangularMatrix{
+public:
+    static_assert(std::is_arithmetic_v<T>, "Type must be arithmetic");
+
+    explicit TriangularMatrix(size_t n_ = 0, Triangle triangle_ = Triangle::Lower, T value = T());
+    //triangle of square matrix, other elements are dropped
+    template <typename U>
+    static TriangularMatrix from_matrix(const Matrix<U> &matrix, Triangle triangle);
+    Matrix<T> to_matrix() const;
+
+    size_t rows() const;
+    size_t columns() const;
+    Triangle triangle() const;
+    //0 outside of stored triangle
+    T operator()(size_t i, size_t j) const;
+    //(i, j) must be in stored triangle
+    void set(size_t i, size_t j, T value);
+
+    Matrix<T> dot(const Matrix<T> &other) const;
+    //X: this * X = b
+    Matrix<T> solve(const Matrix<T> &b) const;
+
+    bool same_structure(const TriangularMatrix &other) const;
+    std::vector<T> &packed();
+    const std::vector<T> &packed() const;
+
+private:
+    bool stored(size_t i, size_t j) const;
+    size_t index(size_t i, size_t j) const;
+
+    size_t n;
+    Triangle uplo;
+    std::vector<T> storage;
+};
+
+//rows x columns matrix with lower bandwidth kl and upper bandwidth ku: (i, j) is stored if -kl <= j - i <= ku,
+//every row keeps kl + ku + 1 slots, (i, j) at i * (kl + ku + 1) + j - i + kl
+template <typename T>
+class BandedMatrix{
+public:
+    static_assert(std::is_arithmetic_v<T>, "Type must be arithmetic");
+
+    BandedMatrix(size_t amountRows_ = 0, size_t amountColumns_ = 0, size_t lower_ = 0, size_t upper_ = 0, T value = T());
+    //band of matrix, other elements are dropped
+    template <typename U>
+    static BandedMatrix from_matrix(const Matrix<U> &matrix, size_t lower, size_t upper);
+    Matrix<T> to_matrix() const;
+
+    size_t rows() const;
+    size_t columns() const;
+    size_t lower_bandwidth() const;
+    size_t upper_bandwidth() const;
+    //0 outside of band
+    T operator()(size_t i, size_t j) const;
+    //(i, j) must be in band
+    void set(size_t i, size_t j, T value);
+
+    Matrix<T> dot(const Matrix<T> &other) const;
+
+    bool same_structure(const BandedMatrix &other) const;
+    std::vector<T> &packed();
+    const std::vector<T> &packed() const;
+
+private:
+    bool stored(size_t i, size_t j) const;
+    size_t index(size_t i, size_t j) const;
+
+    size_t amountRows;
+    size_t amountColumns;
+    size_t lower;
+    size_t upper;
+    std::vector<T> storage;
+};
+
+template <typename T>
+struct is_packed{
+    static const bool value = false;
+};
+
+template <typename T>
+struct is_packed<SymmetricMatrix<T>>{
+    static const bool value = true;
+};
+
+template <typename T>
+struct is_packed<TriangularMatrix<T>>{
+    static const bool value = true;
+};
+
+template <typename T>
+struct is_packed<BandedMatrix<T>>{
+    static const bool value = true;
+};
+
+template <typename T>
+inline constexpr bool is_packed_v = is_packed<T>::value;
+
+//element-wise operations on stored elements of packed matrices of the same structure
+template <typename P>
+std::enable_if_t<is_packed_v<P>, P> operator+(const P &l, const P &r);
+template <typename P>
+std::enable_if_t<is_packed_v<P>, P> operator-(const P &l, const P &r);
+template <typename P>
+std::enable_if_t<is_packed_v<P>, P> operator*(const P &l, const P &r);
+//scaling keeps structure
+template <typename P, typename U>
+std::enable_if_t<is_packed_v<P> && std::is_arithmetic_v<U>, P> operator*(const P &p, U u);
+template <typename P, typename U>
+std::enable_if_t<is_packed_v<P> && std::is_arithmetic_v<U>, P> operator*(U u, const P &p);
+template <typename P, typename U>
+std::enable_if_t<is_packed_v<P> && std::is_arithmetic_v<U>, P> operator/(const P &p, U u);
+
+namespace detail{
+inline void check_square(size_t rows, size_t columns)
+{
+    if(rows != columns)
+        throw std::length_error("matrix must be square");
+}
+
+inline void check_index(size_t i, size_t j, size_t rows, size_t columns)
+{
+    if(i >= rows || j >= columns)
+        throw std::out_of_range("Index exceeds matrix dimensions.");
+}
+
+//out row += a * x row
+template <typename T>
+inline void axpy_row(T *out, T a, const T *x, size_t n)
+{
+    for(size_t k = 0; k < n; ++k)
+        out[k] += a * x[k];
+}
+
+//out(i, :) = sum over j of a(i, j) * x(j, :), rows of out run in parallel,
+//row(i, func) calls func(j, a(i, j)) for every stored element of row i
+template <typename T, typename Row>
+Matrix<T> packed_dot(size_t rows, size_t inner, const Matrix<T> &x, Row row)
+{
+    if(inner != x.rows())
+        throw std::length_error("Inner matrix dimensions must agree");
+    size_t columns = x.columns();
+    Matrix<T> res(rows, columns);
+    const T *px = x.data();
+    T *out = res.data();
+    parallel_for(0, rows, parallel_grain(inner * columns), [&](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i)
+            row(i, [&](size_t j, T a){ axpy_row(out + i * columns, a, px + j * columns, columns); });
+    });
+    return res;
+}
+}
+
+//================================================================================================
+//====================================SymmetricMatrix=============================================
+//================================================================================================
+template <typename T>
+SymmetricMatrix<T>::SymmetricMatrix(size_t n_, T value): n(n_), storage(n_ * (n_ + 1) / 2, value)
+{
+
+}
+
+template <typename T>
+template <typename U>
+SymmetricMatrix<T> SymmetricMatrix<T>::from_matrix(const Matrix<U> &matrix)
+{
+    detail::check_square(matrix.rows(), matrix.columns());
+    SymmetricMatrix<T> res(matrix.rows());
+    for(size_t i = 0; i < res.n; ++i)
+        for(size_t j = 0; j <= i; ++j)
+            res.storage[res.index(i, j)] = matrix(i, j);
+    return res;
+}
+
+template <typename T>
+Matrix<T> SymmetricMatrix<T>::to_matrix() const
+{
+    Matrix<T> res(n, n);
+    for(size_t i = 0; i < n; ++i)
+        for(size_t j = 0; j <= i; ++j)
+            res(i, j) = res(j, i) = storage[index(i, j)];
+    return res;
+}
+
+template <typename T>
+size_t SymmetricMatrix<T>::rows() const
+{
+    return n;
+}
+
+template <typename T>
+size_t SymmetricMatrix<T>::columns() const
+{
+    return n;
+}
+
+template <typename T>
+size_t SymmetricMatrix<T>::index(size_t i, size_t j) const
+{
+    if(j > i)
+        std::swap(i, j);
+    return i * (i + 1) / 2 + j;
+}
+
+template <typename T>
+T SymmetricMatrix<T>::operator()(size_t i, size_t j) const
+{
+    detail::check_index(i, j, n, n);
+    return storage[index(i, j)];
+}
+
+template <typename T>
+void SymmetricMatrix<T>::set(size_t i, size_t j, T value)
+{
+    detail::check_index(i, j, n, n);
+    storage[index(i, j)] = value;
+}
+
+//row i of symmetric matrix is row i of lower triangle and column i below diagonal
+template <typename T>
+Matrix<T> SymmetricMatrix<T>::dot(const Matrix<T> &other) const
+{
+    const T *p = storage.data();
+    return detail::packed_dot(n, n, other, [this, p](size_t i, auto func){
+        const T *row = p + i * (i + 1) / 2;
+        for(size_t j = 0; j <= i; ++j)
+            func(j, row[j]);
+        for(size_t j = i + 1; j < n; ++j)
+            func(j, p[j * (j + 1) / 2 + i]);
+    });
+}
+
+template <typename T>
+bool SymmetricMatrix<T>::same_structure(const SymmetricMatrix &other) const
+{
+    return n == other.n;
+}
+
+template <typename T>
+std::vector<T> &SymmetricMatrix<T>::packed()
+{
+    return storage;
+}
+
+template <typename T>
+const std::vector<T> &SymmetricMatrix<T>::packed() const
+{
+    return storage;
+}
+
+//================================================================================================
+//===================================TriangularMatrix=============================================
+//================================================================================================
+template <typename T>
+TriangularMatrix<T>::TriangularMatrix(size_t n_, Triangle triangle_, T value):
+    n(n_), uplo(triangle_), storage(n_ * (n_ + 1) / 2, value)
+{
+
+}
+
+template <typename T>
+template <typename U>
+TriangularMatrix<T> TriangularMatrix<T>::from_matrix(const Matrix<U> &matrix, Triangle triangle)
+{
+    detail::check_square(matrix.rows(), matrix.columns());
+    TriangularMatrix<T> res(matrix.rows(), triangle);
+    for(size_t i = 0; i < res.n; ++i)
+        for(size_t j = 0; j < res.n; ++j)
+            if(res.stored(i, j))
+                res.storage[res.index(i, j)] = matrix(i, j);
+    return res;
+}
+
+template <typename T>
+Matrix<T> TriangularMatrix<T>::to_matrix() const
+{
+    Matrix<T> res(n, n);
+    for(size_t i = 0; i < n; ++i)
+        for(size_t j = 0; j < n; ++j)
+            if(stored(i, j))
+                res(i, j) = storage[index(i, j)];
+    return res;
+}
+
+template <typename T>
+size_t TriangularMatrix<T>::rows() const
+{
+    return n;
+}
+
+template <typename T>
+size_t TriangularMatrix<T>::columns() const
+{
+    return n;
+}
+
+template <typename T>
+Triangle TriangularMatrix<T>::triangle() const
+{
+    return uplo;
+}
+
+template <typename T>
+bool TriangularMatrix<T>::stored(size_t i, size_t j) const
+{
+    return uplo == Triangle::Lower ? j <= i : j >= i;
+}
+
+//lower: row i starts at i * (i + 1) / 2, upper: row i keeps n - i elements from column i
+template <typename T>
+size_t TriangularMatrix<T>::index(size_t i, size_t j) const
+{
+    if(uplo == Triangle::Lower)
+        return i * (i + 1) / 2 + j;
+    return i * (2 * n - i + 1) / 2 + j - i;
+}
+
+template <typename T>
+T TriangularMatrix<T>::operator()(size_t i, size_t j) const
+{
+    detail::check_index(i, j, n, n);
+    return stored(i, j) ? storage[index(i, j)] : T();
+}
+
+template <typename T>
+void TriangularMatrix<T>::set(size_t i, size_t j, T value)
+{
+    detail::check_index(i, j, n, n);
+    if(!stored(i, j))
+        throw std::out_of_range("element is outside of stored part");
+    storage[index(i, j)] = value;
+}
+
+template <typename T>
+Matrix<T> TriangularMatrix<T>::dot(const Matrix<T> &other) const
+{
+    const T *p = storage.data();
+    return detail::packed_dot(n, n, other, [this, p](size_t i, auto func){
+        size_t first = uplo == Triangle::Lower ? 0 : i, last = uplo == Triangle::Lower ? i + 1 : n;
+        const T *row = p + index(i, first);
+        for(size_t j = first; j < last; ++j)
+            func(j, row[j - first]);
+    });
+}
+
+//forward (lower) or back (upper) substitution, column blocks of b run in parallel
+template <typename T>
+Matrix<T> TriangularMatrix<T>::solve(const Matrix<T> &b) const
+{
+    static_assert(std::is_floating_point_v<T>, "solve requires floating-point type");
+    if(b.rows() != n)
+        throw std::length_error("Inner matrix dimensions must agree");
+    for(size_t i = 0; i < n; ++i)
+        if(storage[index(i, i)] == T())
+            throw std::runtime_error("matrix is singular");
+
+    size_t columns = b.columns();
+    Matrix<T> x(b);
+    T *px = x.data();
+    const T *p = storage.data();
+    detail::parallel_for(0, columns, detail::parallel_grain(n * n / 2), [&](size_t cb, size_t ce){
+        size_t width = ce - cb;
+        for(size_t step = 0; step < n; ++step){
+            size_t i = uplo == Triangle::Lower ? step : n - 1 - step;
+            size_t first = uplo == Triangle::Lower ? 0 : i + 1, last = uplo == Triangle::Lower ? i : n;
+            T *xi = px + i * columns + cb;
+            const T *row = p + index(i, uplo == Triangle::Lower ? 0 : i);
+            for(size_t j = first; j < last; ++j){
+                T a = row[uplo == Triangle::Lower ? j : j - i];
+                detail::axpy_row(xi, -a, px + j * columns + cb, width);
+            }
+            T diagonal = row[uplo == Triangle::Lower ? i : 0];
+            for(size_t k = 0; k < width; ++k)
+                xi[k] /= diagonal;
+        }
+    });
+    return x;
+}
+
+template <typename T>
+bool TriangularMatrix<T>::same_structure(const TriangularMatrix &other) const
+{
+    return n == other.n && uplo == other.uplo;
+}
+
+template <typename T>
+std::vector<T> &TriangularMatrix<T>::packed()
+{
+    return storage;
+}
+
+template <typename T>
+const std::vector<T> &TriangularMatrix<T>::packed() const
+{
+    return storage;
+}
+
+//================================================================================================
+//======================================BandedMatrix==============================================
+//================================================================================================
+template <typename T>
+BandedMatrix<T>::BandedMatrix(size_t amountRows_, size_t amountColumns_, size_t lower_, size_t upper_, T value):
+    amountRows(amountRows_), amountColumns(amountColumns_), lower(lower_), upper(upper_),
+    storage(amountRows_ * (lower_ + upper_ + 1), T())
+{
+    //slots outside of matrix stay 0
+    for(size_t i = 0; i < amountRows; ++i)
+        for(size_t j = i > lower ? i - lower : 0; j < std::min(amountColumns, i + upper + 1); ++j)
+            storage[index(i, j)] = value;
+}
+
+template <typename T>
+template <typename U>
+BandedMatrix<T> BandedMatrix<T>::from_matrix(const Matrix<U> &matrix, size_t lower, size_t upper)
+{
+    BandedMatrix<T> res(matrix.rows(), matrix.columns(), lower, upper);
+    for(size_t i = 0; i < res.amountRows; ++i)
+        for(size_t j = i > lower ? i - lower : 0; j < std::min(res.amountColumns, i + upper + 1); ++j)
+            res.storage[res.index(i, j)] = matrix(i, j);
+    return res;
+}
+
+template <typename T>
+Matrix<T> BandedMatrix<T>::to_matrix() const
+{
+    Matrix<T> res(amountRows, amountColumns);
+    for(size_t i = 0; i < amountRows; ++i)
+        for(size_t j = i > lower ? i - lower : 0; j < std::min(amountColumns, i + upper + 1); ++j)
+            res(i, j) = storage[index(i, j)];
+    return res;
+}
+
+template <typename T>
+size_t BandedMatrix<T>::rows() const
+{
+    return amountRows;
+}
+
+template <typename T>
+size_t BandedMatrix<T>::columns() const
+{
+    return amountColumns;
+}
+
+template <typename T>
+size_t BandedMatrix<T>::lower_bandwidth() const
+{
+    return lower;
+}
+
+template <typename T>
+size_t BandedMatrix<T>::upper_bandwidth() const
+{
+    return upper;
+}
+
+template <typename T>
+bool BandedMatrix<T>::stored(size_t i, size_t j) const
+{
+    return j + lower >= i && j <= i + upper;
+}
+
+template <typename T>
+size_t BandedMatrix<T>::index(size_t i, size_t j) const
+{
+    return i * (lower + upper + 1) + j + lower - i;
+}
+
+template <typename T>
+T BandedMatrix<T>::operator()(size_t i, size_t j) const
+{
+    detail::check_index(i, j, amountRows, amountColumns);
+    return stored(i, j) ? storage[index(i, j)] : T();
+}
+
+template <typename T>
+void BandedMatrix<T>::set(size_t i, size_t j, T value)
+{
+    detail::check_index(i, j, amountRows, amountColumns);
+    if(!stored(i, j))
+        throw std::out_of_range("element is outside of stored part");
+    storage[index(i, j)] = value;
+}
+
+template <typename T>
+Matrix<T> BandedMatrix<T>::dot(const Matrix<T> &other) const
+{
+    const T *p = storage.data();
+    return detail::packed_dot(amountRows, amountColumns, other, [this, p](size_t i, auto func){
+        size_t first = i > lower ? i - lower : 0, last = std::min(amountColumns, i + upper + 1);
+        const T *row = p + index(i, first);
+        for(size_t j = first; j < last; ++j)
+            func(j, row[j - first]);
+    });
+}
+
+template <typename T>
+bool BandedMatrix<T>::same_structure(const BandedMatrix &other) const
+{
+    return amountRows == other.amountRows && amountColumns == other.amountColumns &&
+           lower == other.lower && upper == other.upper;
+}
+
+template <typename T>
+std::vector<T> &BandedMatrix<T>::packed()
+{
+    return storage;
+}
+
+template <typename T>
+const std::vector<T> &BandedMatrix<T>::packed() const
+{
+    return storage;
+}
+
+//================================================================================================
+//===================================packed arithmetic============================================
+//================================================================================================
+namespace detail{
+template <typename P, typename Operation>
+P packed_binary(const P &l, const P &r, Operation oper)
+{
+    if(!l.same_structure(r))
+        throw std::runtime_error("Matrix dimensions must agree");
+    P res(l);
+    auto &out = res.packed();
+    map_kernel(out.data(), out.size(), oper, l.packed().data(), r.packed().data());
+    return res;
+}
+
+template <typename P, typename Operation>
+P packed_unary(const P &p, Operation oper)
+{
+    P res(p);
+    auto &out = res.packed();
+    map_kernel(out.data(), out.size(), oper, p.packed().data());
+    return res;
+}
+}
+
+template <typename P>
+std::enable_if_t<is_packed_v<P>, P> operator+(const P &l, const P &r)
+{
+    return detail::packed_binary(l, r, std::plus<>());
+}
+
+template <typename P>
+std::enable_if_t<is_packed_v<P>, P> operator-(const P &l, const P &r)
+{
+    return detail::packed_binary(l, r, std::minus<>());
+}
+
+template <typename P>
+std::enable_if_t<is_packed_v<P>, P> operator*(const P &l, const P &r)
+{
+    return detail::packed_binary(l, r, std::multiplies<>());
+}
+
+template <typename P, typename U>
+std::enable_if_t<is_packed_v<P> && std::is_arithmetic_v<U>, P> operator*(const P &p, U u)
+{
+    return detail::packed_unary(p, [u](auto x){ return x * u; });
+}
+
+template <typename P, typename U>
+std::enable_if_t<is_packed_v<P> && std::is_arithmetic_v<U>, P> operator*(U u, const P &p)
+{
+    return detail::packed_unary(p, [u](auto x){ return u * x; });
+}
+
+template <typename P, typename U>
+std::enable_if_t<is_packed_v<P> && std::is_arithmetic_v<U>, P> operator/(const P &p, U u)
+{
+    return detail::packed_unary(p, [u](auto x){ return x / u; });
+}
+
+}
+#endif // PACKED_H
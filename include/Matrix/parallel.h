@@ -0,0 +1,116 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include <Matrix/numa.h>
+
+namespace matrix_view{
+
+namespace detail{
+//amount of threads set by user, 0 - all hardware threads
+inline std::atomic<size_t> threads_limit{0};
+//thread runs a chunk of parallel_for, nested parallel_for runs serially
+inline thread_local bool in_parallel = false;
+}
+
+//set amount of threads for parallel kernels, 0 - all hardware threads
+inline void set_threads(size_t n)
+{
+    detail::threads_limit = n;
+}
+
+namespace detail{
+
+//---------------------Helper parallel functions----------------
+//minimal amount of elements, which is worth to split between threads, autotune may change it
+//before kernels run in other threads
+inline size_t parallel_threshold = 1 << 15;
+
+//amount of threads, which kernels may use
+inline size_t hardware_threads()
+{
+    if(size_t limit = threads_limit)
+        return limit;
+    auto n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+//split [first, last) on equal chunks and call func(begin, end) for each chunk,
+//chunk is not less than grain, current thread takes the last chunk,
+//if pin is set, chunk threads are pinned to NUMA node of the chunk
+template <typename Function>
+void parallel_chunks(size_t first, size_t last, size_t grain, bool pin, Function func)
+{
+    if(first >= last)
+        return;
+    size_t n = last - first;
+    size_t threads = in_parallel ? 1 : std::min(hardware_threads(), grain ? n / grain : n);
+    if(threads <= 1){
+        func(first, last);
+        return;
+    }
+
+    size_t chunk = (n + threads - 1) / threads;
+    std::vector<std::thread> pool;
+    std::vector<std::exception_ptr> errors(threads);
+    size_t begin = first;
+    for(size_t t = 0; t + 1 < threads && begin < last; ++t, begin += chunk){
+        size_t end = std::min(begin + chunk, last);
+        pool.emplace_back([&func, &errors, pin, t, threads, begin, end](){
+            numa_pin pinned(pin, t, threads);
+            in_parallel = true;
+            try{
+                func(begin, end);
+            }
+            catch(...){
+                errors[t] = std::current_exception();
+            }
+        });
+    }
+    in_parallel = true;
+    try{
+        numa_pin pinned(pin, threads - 1, threads);
+        if(begin < last)
+            func(begin, last);
+    }
+    catch(...){
+        errors.back() = std::current_exception();
+    }
+    in_parallel = false;
+    for(auto &thread: pool)
+        thread.join();
+    for(auto &error: errors)
+        if(error)
+            std::rethrow_exception(error);
+}
+
+//chunks on threads, which are not pinned
+template <typename Function>
+void parallel_for(size_t first, size_t last, size_t grain, Function func)
+{
+    parallel_chunks(first, last, grain, false, func);
+}
+
+//parallel_for over rows of matrices placed by NumaPlacement::RowBlocks: chunk threads are pinned to
+//node of the rows, so every block of rows is written and read by threads of the same node
+template <typename Function>
+void parallel_rows(size_t first, size_t last, size_t grain, Function func)
+{
+    parallel_chunks(first, last, grain, numa_placement == NumaPlacement::RowBlocks, func);
+}
+
+//grain in items for work, where every item costs itemCost elements
+inline size_t parallel_grain(size_t itemCost)
+{
+    return itemCost ? std::max<size_t>(1, parallel_threshold / itemCost) : parallel_threshold;
+}
+
+}
+
+}
+#endif // PARALLEL_H
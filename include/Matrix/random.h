@@ -0,0 +1,147 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//=====================================Philox4x32-10==============================================
+//================================================================================================
+//counter based generator (Salmon et al., Random123): output depends only on counter and key,
+//so any element can be generated independently of others and of amount of threads
+using philox_block = std::array<uint32_t, 4>;
+
+inline void philox_round(philox_block &counter, uint32_t key0, uint32_t key1)
+{
+    uint64_t product0 = uint64_t(0xD2511F53) * counter[0];
+    uint64_t product1 = uint64_t(0xCD9E8D57) * counter[2];
+    counter = {uint32_t(product1 >> 32) ^ counter[1] ^ key0, uint32_t(product1),
+               uint32_t(product0 >> 32) ^ counter[3] ^ key1, uint32_t(product0)};
+}
+
+inline philox_block philox4x32(philox_block counter, uint64_t seed)
+{
+    uint32_t key0 = uint32_t(seed), key1 = uint32_t(seed >> 32);
+    for(int round = 0; round < 10; ++round){
+        philox_round(counter, key0, key1);
+        key0 += 0x9E3779B9;
+        key1 += 0xBB67AE85;
+    }
+    return counter;
+}
+
+//uniform [0, 1) from 24 bits (float) or 53 bits (double) of block
+template <typename R>
+constexpr size_t uniforms_per_block = sizeof(R) <= 4 ? 4 : 2;
+
+template <typename R>
+inline void philox_uniforms(const philox_block &block, R *out)
+{
+    if constexpr(sizeof(R) <= 4){
+        for(size_t i = 0; i < 4; ++i)
+            out[i] = R(block[i] >> 8) * R(1.0 / (1 << 24));
+    }
+    else{
+        for(size_t i = 0; i < 2; ++i){
+            uint64_t bits = (uint64_t(block[2 * i]) << 32 | block[2 * i + 1]) >> 11;
+            out[i] = R(bits) * R(1.0 / (uint64_t(1) << 53));
+        }
+    }
+}
+
+//call generate(block, out, count) for every block of perBlock elements of matrix in parallel,
+//block number is used as counter
+template <typename T, typename Generate>
+void philox_fill(Matrix<T> &matrix, size_t perBlock, uint64_t seed, Generate generate)
+{
+    T* p = matrix.data();
+    size_t n = matrix.rows() * matrix.columns();
+    size_t blocks = (n + perBlock - 1) / perBlock;
+    parallel_for(0, blocks, parallel_grain(perBlock), [=](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i){
+            auto block = philox4x32({uint32_t(i), uint32_t(uint64_t(i) >> 32), 0, 0}, seed);
+            size_t first = i * perBlock;
+            generate(block, p + first, std::min(perBlock, n - first));
+        }
+    });
+}
+}
+
+//new seed on every call, even if calls are done at the same time
+inline uint64_t random_seed()
+{
+    static std::atomic<uint64_t> calls{0};
+    static const uint64_t base = (uint64_t(std::random_device()()) << 32) ^
+            uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+    return base + 0x9E3779B97F4A7C15 * ++calls;
+}
+
+//-----------------Create matrix-------------------
+template <typename T>
+inline Matrix<T> make_random_matrix(size_t rows, size_t columns, int min, int max)
+{
+    return make_random_matrix<T>(rows, columns, min, max, random_seed());
+}
+
+template <typename T>
+Matrix<T> make_random_matrix(size_t rows, size_t columns, int min, int max, uint64_t seed)
+{
+    if(max <= min)
+        throw std::logic_error("wrong range");
+    uint64_t range = uint64_t(int64_t(max) - min);
+    Matrix<T> m(rows, columns);
+    //multiply-shift maps 32 bits on [0, range)
+    detail::philox_fill(m, 4, seed, [min, range](const detail::philox_block &block, T* out, size_t count){
+        for(size_t i = 0; i < count; ++i)
+            out[i] = static_cast<T>(int64_t(min) + int64_t((block[i] * range) >> 32));
+    });
+    return m;
+}
+
+template <typename T>
+Matrix<T> make_uniform_matrix(size_t rows, size_t columns, T low, T high, uint64_t seed)
+{
+    static_assert(std::is_floating_point_v<T>, "Type must be floating point");
+    Matrix<T> m(rows, columns);
+    detail::philox_fill(m, detail::uniforms_per_block<T>, seed,
+                        [low, high](const detail::philox_block &block, T* out, size_t count){
+        T u[detail::uniforms_per_block<T>];
+        detail::philox_uniforms(block, u);
+        for(size_t i = 0; i < count; ++i)
+            out[i] = low + (high - low) * u[i];
+    });
+    return m;
+}
+
+template <typename T>
+Matrix<T> make_normal_matrix(size_t rows, size_t columns, T mean, T stddev, uint64_t seed)
+{
+    static_assert(std::is_floating_point_v<T>, "Type must be floating point");
+    Matrix<T> m(rows, columns);
+    //Box-Muller transform of pairs of uniforms
+    detail::philox_fill(m, detail::uniforms_per_block<T>, seed,
+                        [mean, stddev](const detail::philox_block &block, T* out, size_t count){
+        constexpr size_t n = detail::uniforms_per_block<T>;
+        T u[n];
+        detail::philox_uniforms(block, u);
+        for(size_t i = 0; i < count; i += 2){
+            T radius = std::sqrt(T(-2) * std::log(T(1) - u[i]));
+            T angle = T(6.283185307179586477) * u[i + 1];
+            out[i] = mean + stddev * radius * std::cos(angle);
+            if(i + 1 < count)
+                out[i + 1] = mean + stddev * radius * std::sin(angle);
+        }
+    });
+    return m;
+}
+
+}
+#endif // RANDOM_H
@@ -0,0 +1,412 @@
+#ifndef REDUCTION_H
+#define REDUCTION_H
+
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//=====================================reduction kernels==========================================
+//================================================================================================
+//elements, which summed without recursion in pairwise summation
+inline constexpr size_t pairwise_block = 128;
+//elements in block of full reduction, blocks don't depend on amount of threads,
+//so result is the same for any amount of threads
+inline constexpr size_t reduction_block = 1 << 14;
+
+//matrix of slice (reference_wrapper) is copied to dense matrix, other matrix is passed as is
+template <typename T>
+decltype(auto) dense(const Matrix<T>& matrix)
+{
+    if constexpr(is_reference_wrapper_v<T>)
+        return Matrix<type_is_t<T>>(matrix);
+    else
+        return (matrix);
+}
+
+struct identity_map{
+    template <typename T>
+    T operator()(T t) const { return t; }
+};
+
+struct abs_map{
+    template <typename T>
+    T operator()(T t) const
+    {
+        if constexpr(std::is_unsigned_v<T>)
+            return t;
+        else
+            return t < 0 ? -t : t;
+    }
+};
+
+struct square_map{
+    template <typename T>
+    T operator()(T t) const { return t * t; }
+};
+
+//pairwise summation of map(first[i]) with simd_lanes accumulators at the leaves
+template <typename Acc, typename T, typename Map>
+Acc pairwise_sum(const T* first, size_t n, Map map)
+{
+    if(n <= pairwise_block){
+        Acc lanes[simd_lanes] = {};
+        size_t i = 0;
+        for(; i + simd_lanes <= n; i += simd_lanes)
+            for(size_t l = 0; l < simd_lanes; ++l)
+                lanes[l] += map(static_cast<Acc>(first[i + l]));
+        for(size_t l = 0; i < n; ++i, ++l)
+            lanes[l] += map(static_cast<Acc>(first[i]));
+        for(size_t width = simd_lanes / 2; width > 0; width /= 2)
+            for(size_t l = 0; l < width; ++l)
+                lanes[l] += lanes[l + width];
+        return lanes[0];
+    }
+    size_t half = n / 2;
+    return pairwise_sum<Acc>(first, half, map) + pairwise_sum<Acc>(first + half, n - half, map);
+}
+
+//value of first[i], for which comp(value, other) is true for all others
+template <typename T, typename Compare>
+T extremum(const T* first, size_t n, Compare comp)
+{
+    T lanes[simd_lanes];
+    std::fill(lanes, lanes + simd_lanes, first[0]);
+    size_t i = 0;
+    for(; i + simd_lanes <= n; i += simd_lanes)
+        for(size_t l = 0; l < simd_lanes; ++l)
+            lanes[l] = comp(first[i + l], lanes[l]) ? first[i + l] : lanes[l];
+    for(; i < n; ++i)
+        lanes[0] = comp(first[i], lanes[0]) ? first[i] : lanes[0];
+    for(size_t l = 1; l < simd_lanes; ++l)
+        lanes[0] = comp(lanes[l], lanes[0]) ? lanes[l] : lanes[0];
+    return lanes[0];
+}
+
+//index of extremum, the first one if there are equal values
+template <typename T, typename Compare>
+size_t arg_extremum(const T* first, size_t n, Compare comp)
+{
+    size_t best = 0;
+    for(size_t i = 1; i < n; ++i)
+        if(comp(first[i], first[best]))
+            best = i;
+    return best;
+}
+
+//call func(begin, end) for every reduction_block of [0, n) in parallel, return results of blocks
+template <typename Result, typename BlockFunction>
+std::vector<Result> reduce_blocks(size_t n, BlockFunction func)
+{
+    size_t blocks = (n + reduction_block - 1) / reduction_block;
+    std::vector<Result> partial(blocks);
+    parallel_for(0, blocks, parallel_grain(reduction_block), [&](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i){
+            size_t first = i * reduction_block;
+            partial[i] = func(first, std::min(first + reduction_block, n));
+        }
+    });
+    return partial;
+}
+
+template <typename Acc, typename T, typename Map>
+Acc full_sum(const T* p, size_t n, Map map)
+{
+    if(n == 0)
+        return Acc();
+    auto partial = reduce_blocks<Acc>(n, [p, map](size_t b, size_t e){
+        return pairwise_sum<Acc>(p + b, e - b, map);
+    });
+    return pairwise_sum<Acc>(partial.data(), partial.size(), identity_map());
+}
+
+template <typename T, typename Compare>
+T full_extremum(const T* p, size_t n, Compare comp)
+{
+    if(n == 0)
+        throw std::length_error("matrix is empty");
+    auto partial = reduce_blocks<T>(n, [p, comp](size_t b, size_t e){
+        return extremum(p + b, e - b, comp);
+    });
+    return extremum(partial.data(), partial.size(), comp);
+}
+
+template <typename T, typename Compare>
+size_t full_arg_extremum(const T* p, size_t n, Compare comp)
+{
+    if(n == 0)
+        throw std::length_error("matrix is empty");
+    auto partial = reduce_blocks<size_t>(n, [p, comp](size_t b, size_t e){
+        return b + arg_extremum(p + b, e - b, comp);
+    });
+    size_t best = partial[0];
+    for(size_t i = 1; i < partial.size(); ++i)
+        if(comp(p[partial[i]], p[best]))
+            best = partial[i];
+    return best;
+}
+
+//result of reduction along axis: 0 - 1xC, 1 - Rx1
+template <typename Result, typename T>
+Matrix<Result> axis_result(const Matrix<T>& matrix, size_t axis)
+{
+    if(axis == 0)
+        return Matrix<Result>(1, matrix.columns());
+    if(axis == 1)
+        return Matrix<Result>(matrix.rows(), 1);
+    throw std::logic_error("wrong axis");
+}
+
+//func(row pointer, columns) for every row in parallel
+template <typename Result, typename T, typename RowFunction>
+void reduce_rows(const Matrix<T>& matrix, Matrix<Result>& res, RowFunction func)
+{
+    const T* p = matrix.data();
+    size_t columns = matrix.columns();
+    Result* out = res.data();
+    parallel_for(0, matrix.rows(), parallel_grain(columns), [=](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i)
+            out[i] = func(p + i * columns, columns);
+    });
+}
+
+//sum of map(x) along columns, matrix is traversed row by row,
+//threads take strips of columns, floating sums use Kahan compensation
+template <typename Acc, typename T, typename Map>
+void sum_columns(const Matrix<T>& matrix, Acc* out, Map map)
+{
+    const T* p = matrix.data();
+    size_t rows = matrix.rows(), columns = matrix.columns();
+    parallel_for(0, columns, parallel_grain(rows), [=](size_t b, size_t e){
+        std::vector<Acc> compensation(e - b);
+        for(size_t i = 0; i < rows; ++i){
+            const T* row = p + i * columns;
+            if constexpr(std::is_floating_point_v<Acc>){
+                for(size_t j = b; j < e; ++j){
+                    Acc y = map(static_cast<Acc>(row[j])) - compensation[j - b];
+                    Acc t = out[j] + y;
+                    compensation[j - b] = (t - out[j]) - y;
+                    out[j] = t;
+                }
+            }
+            else{
+                for(size_t j = b; j < e; ++j)
+                    out[j] += map(static_cast<Acc>(row[j]));
+            }
+        }
+    });
+}
+
+//extremum (or its row index if Index) along columns, matrix is traversed row by row
+template <bool Index, typename Result, typename T, typename Compare>
+void extremum_columns(const Matrix<T>& matrix, Result* out, Compare comp)
+{
+    if(matrix.rows() == 0)
+        throw std::length_error("matrix is empty");
+    const T* p = matrix.data();
+    size_t rows = matrix.rows(), columns = matrix.columns();
+    parallel_for(0, columns, parallel_grain(rows), [=](size_t b, size_t e){
+        std::vector<T> best(p + b, p + e);
+        std::vector<size_t> index(e - b, 0);
+        for(size_t i = 1; i < rows; ++i){
+            const T* row = p + i * columns;
+            for(size_t j = b; j < e; ++j){
+                bool better = comp(row[j], best[j - b]);
+                best[j - b] = better ? row[j] : best[j - b];
+                index[j - b] = better ? i : index[j - b];
+            }
+        }
+        if constexpr(Index)
+            std::copy(index.begin(), index.end(), out + b);
+        else
+            std::copy(best.begin(), best.end(), out + b);
+    });
+}
+
+template <typename T, typename Compare>
+Matrix<T> axis_extremum(const Matrix<T>& matrix, size_t axis, Compare comp)
+{
+    auto res = axis_result<T>(matrix, axis);
+    if(axis == 0)
+        extremum_columns<false>(matrix, res.data(), comp);
+    else
+        reduce_rows(matrix, res, [comp](const T* row, size_t n){
+            if(n == 0)
+                throw std::length_error("matrix is empty");
+            return extremum(row, n, comp);
+        });
+    return res;
+}
+
+template <typename T, typename Compare>
+Matrix<size_t> axis_arg_extremum(const Matrix<T>& matrix, size_t axis, Compare comp)
+{
+    auto res = axis_result<size_t>(matrix, axis);
+    if(axis == 0)
+        extremum_columns<true>(matrix, res.data(), comp);
+    else
+        reduce_rows(matrix, res, [comp](const T* row, size_t n){
+            if(n == 0)
+                throw std::length_error("matrix is empty");
+            return arg_extremum(row, n, comp);
+        });
+    return res;
+}
+
+template <typename Acc, typename T, typename Map>
+Matrix<Acc> axis_sum(const Matrix<T>& matrix, size_t axis, Map map)
+{
+    auto res = axis_result<Acc>(matrix, axis);
+    if(axis == 0)
+        sum_columns(matrix, res.data(), map);
+    else
+        reduce_rows(matrix, res, [map](const T* row, size_t n){
+            return pairwise_sum<Acc>(row, n, map);
+        });
+    return res;
+}
+
+}
+
+//================================================================================================
+//=========================================reductions=============================================
+//================================================================================================
+template <typename T>
+type_is_t<T> sum(const Matrix<T>& matrix)
+{
+    const auto& m = detail::dense(matrix);
+    return detail::full_sum<type_is_t<T>>(m.data(), m.rows() * m.columns(), detail::identity_map());
+}
+
+template <typename T>
+Matrix<type_is_t<T>> sum(const Matrix<T>& matrix, size_t axis)
+{
+    return detail::axis_sum<type_is_t<T>>(detail::dense(matrix), axis, detail::identity_map());
+}
+
+template <typename T>
+real_type_t<T> mean(const Matrix<T>& matrix)
+{
+    const auto& m = detail::dense(matrix);
+    size_t n = m.rows() * m.columns();
+    if(n == 0)
+        throw std::length_error("matrix is empty");
+    return detail::full_sum<real_type_t<T>>(m.data(), n, detail::identity_map()) / n;
+}
+
+template <typename T>
+Matrix<real_type_t<T>> mean(const Matrix<T>& matrix, size_t axis)
+{
+    const auto& m = detail::dense(matrix);
+    auto res = detail::axis_sum<real_type_t<T>>(m, axis, detail::identity_map());
+    res /= static_cast<real_type_t<T>>(axis == 0 ? m.rows() : m.columns());
+    return res;
+}
+
+template <typename T>
+type_is_t<T> min(const Matrix<T>& matrix)
+{
+    const auto& m = detail::dense(matrix);
+    return detail::full_extremum(m.data(), m.rows() * m.columns(), std::less<>());
+}
+
+template <typename T>
+Matrix<type_is_t<T>> min(const Matrix<T>& matrix, size_t axis)
+{
+    return detail::axis_extremum(detail::dense(matrix), axis, std::less<>());
+}
+
+template <typename T>
+type_is_t<T> max(const Matrix<T>& matrix)
+{
+    const auto& m = detail::dense(matrix);
+    return detail::full_extremum(m.data(), m.rows() * m.columns(), std::greater<>());
+}
+
+template <typename T>
+Matrix<type_is_t<T>> max(const Matrix<T>& matrix, size_t axis)
+{
+    return detail::axis_extremum(detail::dense(matrix), axis, std::greater<>());
+}
+
+template <typename T>
+size_t argmin(const Matrix<T>& matrix)
+{
+    const auto& m = detail::dense(matrix);
+    return detail::full_arg_extremum(m.data(), m.rows() * m.columns(), std::less<>());
+}
+
+template <typename T>
+Matrix<size_t> argmin(const Matrix<T>& matrix, size_t axis)
+{
+    return detail::axis_arg_extremum(detail::dense(matrix), axis, std::less<>());
+}
+
+template <typename T>
+size_t argmax(const Matrix<T>& matrix)
+{
+    const auto& m = detail::dense(matrix);
+    return detail::full_arg_extremum(m.data(), m.rows() * m.columns(), std::greater<>());
+}
+
+template <typename T>
+Matrix<size_t> argmax(const Matrix<T>& matrix, size_t axis)
+{
+    return detail::axis_arg_extremum(detail::dense(matrix), axis, std::greater<>());
+}
+
+template <typename T>
+real_type_t<T> norm(const Matrix<T>& matrix, Norm ord)
+{
+    using R = real_type_t<T>;
+    const auto& m = detail::dense(matrix);
+    size_t n = m.rows() * m.columns();
+    switch(ord){
+    case Norm::L1:
+        return detail::full_sum<R>(m.data(), n, detail::abs_map());
+    case Norm::L2:
+        return std::sqrt(detail::full_sum<R>(m.data(), n, detail::square_map()));
+    default:{
+        if(n == 0)
+            return R();
+        //max |x| = max(|max x|, |min x|), so there is no copy of abs values
+        R high = std::fabs(static_cast<R>(detail::full_extremum(m.data(), n, std::greater<>())));
+        R low = std::fabs(static_cast<R>(detail::full_extremum(m.data(), n, std::less<>())));
+        return std::max(high, low);
+    }
+    }
+}
+
+template <typename T>
+Matrix<real_type_t<T>> norm(const Matrix<T>& matrix, size_t axis, Norm ord)
+{
+    using R = real_type_t<T>;
+    const auto& m = detail::dense(matrix);
+    switch(ord){
+    case Norm::L1:
+        return detail::axis_sum<R>(m, axis, detail::abs_map());
+    case Norm::L2:{
+        auto res = detail::axis_sum<R>(m, axis, detail::square_map());
+        for(auto &item: res)
+            item = std::sqrt(item);
+        return res;
+    }
+    default:{
+        Matrix<R> high(detail::axis_extremum(m, axis, std::greater<>()));
+        Matrix<R> low(detail::axis_extremum(m, axis, std::less<>()));
+        auto it = low.begin();
+        for(auto &item: high){
+            item = std::max(std::fabs(item), std::fabs(*it));
+            ++it;
+        }
+        return high;
+    }
+    }
+}
+
+}
+#endif // REDUCTION_H
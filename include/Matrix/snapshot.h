@@ -0,0 +1,170 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//=======================================snapshot slots===========================================
+//================================================================================================
+//reference count of slot, which writer fills; readers, which see it, are not counted
+//until it is published
+inline constexpr size_t writer_reference = size_t(1) << (sizeof(size_t) * 8 - 2);
+
+//version of matrix, it is reused by writer, when no reader holds it and it is not current
+template <typename T>
+struct snapshot_slot{
+    Matrix<T> matrix;
+    size_t version = 0;
+    std::atomic<size_t> references{0};
+};
+}
+
+template <typename T>
+class SnapshotMatrix;
+
+//================================================================================================
+//==========================================Snapshot==============================================
+//================================================================================================
+//immutable version of SnapshotMatrix, valid while handle exists; it must not outlive SnapshotMatrix
+template <typename T>
+class Snapshot{
+public:
+    Snapshot() = default;
+    Snapshot(const Snapshot &other): slot(other.slot)
+    {
+        if(slot)
+            slot->references.fetch_add(1, std::memory_order_relaxed);
+    }
+    Snapshot(Snapshot &&other) noexcept: slot(std::exchange(other.slot, nullptr)) {}
+    Snapshot &operator=(Snapshot other) noexcept
+    {
+        std::swap(slot, other.slot);
+        return *this;
+    }
+    ~Snapshot()
+    {
+        if(slot)
+            slot->references.fetch_sub(1, std::memory_order_release);
+    }
+
+    const Matrix<T> &operator*() const { return slot->matrix; }
+    const Matrix<T> *operator->() const { return &slot->matrix; }
+    const Matrix<T> &matrix() const { return slot->matrix; }
+    //1 for the first published matrix, increases by 1 on every publish
+    size_t version() const { return slot->version; }
+    explicit operator bool() const { return slot != nullptr; }
+
+private:
+    explicit Snapshot(detail::snapshot_slot<T> *slot_): slot(slot_) {}
+
+    detail::snapshot_slot<T> *slot = nullptr;
+
+    friend class SnapshotMatrix<T>;
+};
+
+//================================================================================================
+//=======================================SnapshotMatrix===========================================
+//================================================================================================
+//matrix shared by one writer and many readers: read() is lock-free and returns a consistent
+//Snapshot, publish and update fill a retired buffer and make it current by one atomic store,
+//so steady state does not allocate
+template <typename T>
+class SnapshotMatrix{
+public:
+    explicit SnapshotMatrix(Matrix<T> matrix = Matrix<T>())
+    {
+        auto slot = std::make_unique<detail::snapshot_slot<T>>();
+        slot->matrix = std::move(matrix);
+        slot->version = 1;
+        current.store(slot.get());
+        slots.push_back(std::move(slot));
+    }
+    SnapshotMatrix(const SnapshotMatrix&) = delete;
+    SnapshotMatrix &operator=(const SnapshotMatrix&) = delete;
+
+    //reader: count reference, then check, that slot is still current; if writer has replaced it
+    //in between, slot may be being refilled, so reference is dropped and read is retried
+    Snapshot<T> read() const
+    {
+        for(;;){
+            auto slot = current.load();
+            slot->references.fetch_add(1);
+            if(current.load() == slot)
+                return Snapshot<T>(slot);
+            slot->references.fetch_sub(1);
+        }
+    }
+
+    //writer: matrix becomes current version
+    void publish(const Matrix<T> &matrix)
+    {
+        std::lock_guard<std::mutex> lock(writer);
+        auto slot = acquire();
+        slot->matrix = matrix;
+        install(slot);
+    }
+
+    void publish(Matrix<T> &&matrix)
+    {
+        std::lock_guard<std::mutex> lock(writer);
+        auto slot = acquire();
+        slot->matrix = std::move(matrix);
+        install(slot);
+    }
+
+    //writer: func(Matrix<T>&) changes copy of current version, which is published then
+    template <typename Func>
+    void update(Func &&func)
+    {
+        std::lock_guard<std::mutex> lock(writer);
+        auto slot = acquire();
+        slot->matrix = current.load()->matrix;
+        func(slot->matrix);
+        install(slot);
+    }
+
+    size_t version() const { return current.load()->version; }
+    //buffers allocated so far, current one and the ones readers still hold
+    size_t buffers() const
+    {
+        std::lock_guard<std::mutex> lock(writer);
+        return slots.size();
+    }
+
+private:
+    //retired slot, which no reader holds, it is marked by writer reference, so late readers back off
+    detail::snapshot_slot<T> *acquire()
+    {
+        auto live = current.load();
+        for(auto &slot: slots){
+            size_t free = 0;
+            if(slot.get() != live &&
+               slot->references.compare_exchange_strong(free, detail::writer_reference, std::memory_order_acquire))
+                return slot.get();
+        }
+        slots.push_back(std::make_unique<detail::snapshot_slot<T>>());
+        slots.back()->references.store(detail::writer_reference);
+        return slots.back().get();
+    }
+
+    void install(detail::snapshot_slot<T> *slot)
+    {
+        slot->version = current.load()->version + 1;
+        current.store(slot);
+        slot->references.fetch_sub(detail::writer_reference);
+    }
+
+    std::atomic<detail::snapshot_slot<T>*> current{nullptr};
+    std::vector<std::unique_ptr<detail::snapshot_slot<T>>> slots;
+    mutable std::mutex writer;
+};
+
+}
+#endif // SNAPSHOT_H
@@ -0,0 +1,274 @@
+#ifndef SORTING_H
+#define SORTING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace matrix_view {
+
+namespace detail{
+//================================================================================================
+//======================================sorting kernels===========================================
+//================================================================================================
+//lines up to this length are sorted by sorting network, simd_lanes lines at once
+inline constexpr size_t network_max = 16;
+
+template <typename T>
+struct keyed{
+    T value;
+    size_t index;
+};
+
+//order of elements, equal values keep order of indices
+template <bool Descending, typename T>
+inline bool before(const T &a, size_t ia, const T &b, size_t ib)
+{
+    if constexpr(Descending)
+        return a > b || (a == b && ia < ib);
+    else
+        return a < b || (a == b && ia < ib);
+}
+
+//value, which goes after all values of T
+template <bool Descending, typename T>
+constexpr T sort_sentinel()
+{
+    if constexpr(std::numeric_limits<T>::has_infinity)
+        return Descending ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+    else
+        return Descending ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max();
+}
+
+//compare-exchange pairs of Batcher odd-even merge sort for n = 2^m
+inline std::vector<std::pair<uint8_t, uint8_t>> network_pairs(size_t n)
+{
+    std::vector<std::pair<uint8_t, uint8_t>> pairs;
+    for(size_t p = 1; p < n; p <<= 1)
+        for(size_t k = p; k >= 1; k >>= 1)
+            for(size_t j = k % p; j + k < n; j += 2 * k)
+                for(size_t i = 0; i < std::min(k, n - j - k); ++i)
+                    if((i + j) / (2 * p) == (i + j + k) / (2 * p))
+                        pairs.emplace_back(uint8_t(i + j), uint8_t(i + j + k));
+    return pairs;
+}
+
+inline const std::vector<std::pair<uint8_t, uint8_t>> &sorting_network(size_t n)
+{
+    static const std::vector<std::pair<uint8_t, uint8_t>> networks[] = {
+        network_pairs(1), network_pairs(2), network_pairs(4), network_pairs(8), network_pairs(16)
+    };
+    size_t level = 0;
+    while((size_t(1) << level) < n)
+        ++level;
+    return networks[level];
+}
+
+//destination of selected elements: element j of line i is at base + i * lineStride + j * step
+template <typename T>
+struct line_output{
+    T *p;
+    size_t lineStride;
+    size_t step;
+
+    T &at(size_t line, size_t j) const { return p[line * lineStride + j * step]; }
+};
+
+//sorts simd_lanes lines of count <= network_max elements at once, every compare-exchange is done
+//for all lanes by branchless min/max, the first k elements of every line are written
+template <bool Descending, typename T>
+void network_lines(const T *src, size_t first, size_t lines, size_t count, size_t lineStride, size_t step,
+                   size_t k, const line_output<T> &values, const line_output<size_t> &indices)
+{
+    size_t n = 1;
+    while(n < count)
+        n <<= 1;
+    const auto &network = sorting_network(n);
+    T v[network_max][simd_lanes];
+    size_t ix[network_max][simd_lanes];
+    for(size_t l0 = first; l0 < first + lines; l0 += simd_lanes){
+        size_t lanes = std::min(simd_lanes, first + lines - l0);
+        for(size_t j = 0; j < n; ++j){
+            for(size_t l = 0; l < simd_lanes; ++l){
+                bool present = l < lanes && j < count;
+                v[j][l] = present ? src[(l0 + l) * lineStride + j * step] : sort_sentinel<Descending, T>();
+                ix[j][l] = present ? j : std::numeric_limits<size_t>::max();
+            }
+        }
+        for(auto [a, b]: network){
+            for(size_t l = 0; l < simd_lanes; ++l){
+                bool swap = before<Descending>(v[b][l], ix[b][l], v[a][l], ix[a][l]);
+                T va = v[a][l], vb = v[b][l];
+                size_t ia = ix[a][l], ib = ix[b][l];
+                v[a][l] = swap ? vb : va;
+                v[b][l] = swap ? va : vb;
+                ix[a][l] = swap ? ib : ia;
+                ix[b][l] = swap ? ia : ib;
+            }
+        }
+        for(size_t l = 0; l < lanes; ++l){
+            for(size_t j = 0; j < k; ++j){
+                if(values.p)
+                    values.at(l0 + l, j) = v[j][l];
+                if(indices.p)
+                    indices.at(l0 + l, j) = ix[j][l];
+            }
+        }
+    }
+}
+
+//first k elements of sorted line in buffer: full sort, bounded heap for small k, nth_element otherwise
+template <bool Descending, typename T>
+void select_line(std::vector<keyed<T>> &buffer, size_t k)
+{
+    auto less = [](const keyed<T> &a, const keyed<T> &b){
+        return before<Descending>(a.value, a.index, b.value, b.index);
+    };
+    if(k == buffer.size())
+        std::sort(buffer.begin(), buffer.end(), less);
+    else if(k * 16 <= buffer.size()){
+        //heap keeps the best k, its top is the worst of them
+        auto end = buffer.begin() + std::ptrdiff_t(k);
+        std::make_heap(buffer.begin(), end, less);
+        for(auto it = end; it != buffer.end(); ++it){
+            if(less(*it, buffer.front())){
+                std::pop_heap(buffer.begin(), end, less);
+                *(end - 1) = *it;
+                std::push_heap(buffer.begin(), end, less);
+            }
+        }
+        std::sort_heap(buffer.begin(), end, less);
+    }
+    else{
+        auto end = buffer.begin() + std::ptrdiff_t(k);
+        std::nth_element(buffer.begin(), end, buffer.end(), less);
+        std::sort(buffer.begin(), end, less);
+    }
+}
+
+//the first k sorted elements of every line of src, lines run in parallel
+template <bool Descending, typename T>
+void select_lines(const T *src, size_t lines, size_t count, size_t lineStride, size_t step, size_t k,
+                  const line_output<T> &values, const line_output<size_t> &indices)
+{
+    if(lines == 0 || k == 0)
+        return;
+    if(count <= network_max){
+        size_t batches = (lines + simd_lanes - 1) / simd_lanes;
+        parallel_for(0, batches, parallel_grain(simd_lanes * network_max * 4), [&](size_t b, size_t e){
+            size_t first = b * simd_lanes, last = std::min(lines, e * simd_lanes);
+            network_lines<Descending>(src, first, last - first, count, lineStride, step, k, values, indices);
+        });
+        return;
+    }
+    parallel_for(0, lines, parallel_grain(count * 8), [&](size_t b, size_t e){
+        std::vector<keyed<T>> buffer(count);
+        for(size_t i = b; i < e; ++i){
+            for(size_t j = 0; j < count; ++j)
+                buffer[j] = {src[i * lineStride + j * step], j};
+            select_line<Descending>(buffer, k);
+            for(size_t j = 0; j < k; ++j){
+                if(values.p)
+                    values.at(i, j) = buffer[j].value;
+                if(indices.p)
+                    indices.at(i, j) = buffer[j].index;
+            }
+        }
+    });
+}
+
+//axis 1 - every row is sorted, axis 0 - every column is sorted
+template <typename T>
+void select(const Matrix<T>& matrix, size_t axis, size_t k, Order order, T *values, size_t *indices)
+{
+    size_t rows = matrix.rows(), columns = matrix.columns();
+    size_t lines = axis ? rows : columns, count = axis ? columns : rows;
+    if(k > count)
+        throw std::logic_error("wrong range");
+    //row lines: line i starts at i * columns, column lines: line i starts at i, step columns;
+    //output has k elements per line in the same orientation
+    size_t lineStride = axis ? columns : 1, step = axis ? 1 : columns;
+    size_t outLineStride = axis ? k : 1, outStep = axis ? 1 : columns;
+    line_output<T> v{values, outLineStride, outStep};
+    line_output<size_t> ix{indices, outLineStride, outStep};
+    if(order == Order::Descending)
+        select_lines<true>(matrix.data(), lines, count, lineStride, step, k, v, ix);
+    else
+        select_lines<false>(matrix.data(), lines, count, lineStride, step, k, v, ix);
+}
+
+template <typename T>
+Matrix<type_is_t<T>> sort_axis(const Matrix<T>& matrix, size_t axis, Order order)
+{
+    const auto& m = dense(matrix);
+    Matrix<type_is_t<T>> res(m.rows(), m.columns());
+    select(m, axis, axis ? m.columns() : m.rows(), order, res.data(), static_cast<size_t*>(nullptr));
+    return res;
+}
+
+template <typename T>
+Matrix<size_t> argsort_axis(const Matrix<T>& matrix, size_t axis, Order order)
+{
+    const auto& m = dense(matrix);
+    Matrix<size_t> res(m.rows(), m.columns());
+    select(m, axis, axis ? m.columns() : m.rows(), order, static_cast<type_is_t<T>*>(nullptr), res.data());
+    return res;
+}
+
+template <typename T>
+TopK<type_is_t<T>> topk_axis(const Matrix<T>& matrix, size_t k, size_t axis, Order order)
+{
+    const auto& m = dense(matrix);
+    size_t rows = axis ? m.rows() : k, columns = axis ? k : m.columns();
+    if(k > (axis ? m.columns() : m.rows()))
+        throw std::logic_error("wrong range");
+    TopK<type_is_t<T>> res{Matrix<type_is_t<T>>(rows, columns), Matrix<size_t>(rows, columns)};
+    select(m, axis, k, order, res.values.data(), res.indices.data());
+    return res;
+}
+}
+
+//================================================================================================
+//=========================================sorting================================================
+//================================================================================================
+template <typename T>
+Matrix<type_is_t<T>> sort_rows(const Matrix<T>& matrix, Order order)
+{
+    return detail::sort_axis(matrix, 1, order);
+}
+
+template <typename T>
+Matrix<type_is_t<T>> sort_cols(const Matrix<T>& matrix, Order order)
+{
+    return detail::sort_axis(matrix, 0, order);
+}
+
+template <typename T>
+Matrix<size_t> argsort_rows(const Matrix<T>& matrix, Order order)
+{
+    return detail::argsort_axis(matrix, 1, order);
+}
+
+template <typename T>
+Matrix<size_t> argsort_cols(const Matrix<T>& matrix, Order order)
+{
+    return detail::argsort_axis(matrix, 0, order);
+}
+
+template <typename T>
+TopK<type_is_t<T>> topk_rows(const Matrix<T>& matrix, size_t k, Order order)
+{
+    return detail::topk_axis(matrix, k, 1, order);
+}
+
+template <typename T>
+TopK<type_is_t<T>> topk_cols(const Matrix<T>& matrix, size_t k, Order order)
+{
+    return detail::topk_axis(matrix, k, 0, order);
+}
+
+}
+#endif // SORTING_H
@@ -0,0 +1,552 @@
+#ifndef STRUCTURED_H
+#define STRUCTURED_H
+
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace matrix_view {
+
+//================================================================================================
+//===================================lazy structured matrices=====================================
+//================================================================================================
+//rows x columns matrix with all elements equal to value, stores only value
+template <typename T>
+class Constant{
+public:
+    static_assert(std::is_arithmetic_v<T>, "Type must be arithmetic");
+
+    Constant(size_t amountRows_, size_t amountColumns_, T value_);
+
+    size_t rows() const;
+    size_t columns() const;
+    T value() const;
+    T operator()(size_t i, size_t j) const;
+
+    //dense copy, which may be written
+    Matrix<T> to_matrix() const;
+    operator Matrix<T>() const;
+
+    //every row of result is value * column sums of other
+    Matrix<T> dot(const Matrix<T> &other) const;
+
+private:
+    size_t amountRows;
+    size_t amountColumns;
+    T constant;
+};
+
+//n x n identity matrix, stores nothing
+template <typename T>
+class Identity{
+public:
+    static_assert(std::is_arithmetic_v<T>, "Type must be arithmetic");
+
+    explicit Identity(size_t n_);
+
+    size_t rows() const;
+    size_t columns() const;
+    T operator()(size_t i, size_t j) const;
+
+    Matrix<T> to_matrix() const;
+    operator Matrix<T>() const;
+
+    //copy of other
+    Matrix<T> dot(const Matrix<T> &other) const;
+
+private:
+    size_t n;
+};
+
+//n x n diagonal matrix, stores n diagonal elements
+template <typename T>
+class Diagonal{
+public:
+    static_assert(std::is_arithmetic_v<T>, "Type must be arithmetic");
+
+    explicit Diagonal(std::vector<T> values_);
+    //diagonal from vector: 1xN or Nx1 matrix
+    explicit Diagonal(const Matrix<T> &vector);
+
+    size_t rows() const;
+    size_t columns() const;
+    const std::vector<T> &values() const;
+    T operator()(size_t i, size_t j) const;
+
+    Matrix<T> to_matrix() const;
+    operator Matrix<T>() const;
+
+    //rows of other are scaled
+    Matrix<T> dot(const Matrix<T> &other) const;
+    Diagonal dot(const Diagonal &other) const;
+
+private:
+    std::vector<T> diagonal;
+};
+
+template <typename T>
+struct is_lazy{
+    static const bool value = false;
+};
+
+template <typename T>
+struct is_lazy<Constant<T>>{
+    static const bool value = true;
+};
+
+template <typename T>
+struct is_lazy<Identity<T>>{
+    static const bool value = true;
+};
+
+template <typename T>
+struct is_lazy<Diagonal<T>>{
+    static const bool value = true;
+};
+
+template <typename T>
+inline constexpr bool is_lazy_v = is_lazy<T>::value;
+
+//matrix * lazy matrix: columns of matrix are scaled (Diagonal), copied (Identity) or row sums are spread (Constant)
+template <typename T>
+Matrix<T> dot(const Matrix<T> &matrix, const Constant<T> &c);
+template <typename T>
+Matrix<T> dot(const Matrix<T> &matrix, const Identity<T> &identity);
+template <typename T>
+Matrix<T> dot(const Matrix<T> &matrix, const Diagonal<T> &d);
+
+//matrix +- lazy matrix: Constant adds value to every element, Identity and Diagonal add only the diagonal
+template <typename T, typename L>
+std::enable_if_t<is_lazy_v<L>, Matrix<T>> operator+(const Matrix<T> &matrix, const L &l);
+template <typename T, typename L>
+std::enable_if_t<is_lazy_v<L>, Matrix<T>> operator+(const L &l, const Matrix<T> &matrix);
+template <typename T, typename L>
+std::enable_if_t<is_lazy_v<L>, Matrix<T>> operator-(const Matrix<T> &matrix, const L &l);
+template <typename T, typename L>
+std::enable_if_t<is_lazy_v<L>, Matrix<T>> operator-(const L &l, const Matrix<T> &matrix);
+
+//element-wise products, only diagonal of matrix is read for Identity and Diagonal
+template <typename T>
+Matrix<T> operator*(const Matrix<T> &matrix, const Constant<T> &c);
+template <typename T>
+Matrix<T> operator*(const Constant<T> &c, const Matrix<T> &matrix);
+template <typename T>
+Diagonal<T> operator*(const Matrix<T> &matrix, const Diagonal<T> &d);
+template <typename T>
+Diagonal<T> operator*(const Diagonal<T> &d, const Matrix<T> &matrix);
+
+template <typename T>
+Diagonal<T> operator+(const Diagonal<T> &l, const Diagonal<T> &r);
+template <typename T>
+Diagonal<T> operator-(const Diagonal<T> &l, const Diagonal<T> &r);
+template <typename T>
+Diagonal<T> operator*(const Diagonal<T> &l, const Diagonal<T> &r);
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Diagonal<T>> operator*(const Diagonal<T> &d, U u);
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Diagonal<T>> operator*(U u, const Diagonal<T> &d);
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Diagonal<T>> operator*(const Identity<T> &identity, U u);
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Diagonal<T>> operator*(U u, const Identity<T> &identity);
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Constant<T>> operator*(const Constant<T> &c, U u);
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Constant<T>> operator*(U u, const Constant<T> &c);
+
+namespace detail{
+inline void check_same_shape(size_t rows, size_t columns, size_t otherRows, size_t otherColumns)
+{
+    if(rows != otherRows || columns != otherColumns)
+        throw std::runtime_error("Matrix dimensions must agree");
+}
+
+inline void check_inner(size_t columns, size_t otherRows)
+{
+    if(columns != otherRows)
+        throw std::length_error("Inner matrix dimensions must agree");
+}
+
+//res += sign * l, only the diagonal is touched for Identity and Diagonal
+template <typename T, typename L>
+void add_lazy(Matrix<T> &res, const L &l, T sign)
+{
+    check_same_shape(res.rows(), res.columns(), l.rows(), l.columns());
+    if constexpr(std::is_same_v<L, Constant<T>>)
+        res += sign * l.value();
+    else{
+        T *p = res.data();
+        for(size_t i = 0; i < l.rows(); ++i)
+            p[i * res.columns() + i] += sign * l(i, i);
+    }
+}
+}
+
+//================================================================================================
+//=========================================Constant===============================================
+//================================================================================================
+template <typename T>
+Constant<T>::Constant(size_t amountRows_, size_t amountColumns_, T value_):
+    amountRows(amountRows_), amountColumns(amountColumns_), constant(value_)
+{
+
+}
+
+template <typename T>
+size_t Constant<T>::rows() const
+{
+    return amountRows;
+}
+
+template <typename T>
+size_t Constant<T>::columns() const
+{
+    return amountColumns;
+}
+
+template <typename T>
+T Constant<T>::value() const
+{
+    return constant;
+}
+
+template <typename T>
+T Constant<T>::operator()(size_t i, size_t j) const
+{
+    detail::check_index(i, j, amountRows, amountColumns);
+    return constant;
+}
+
+template <typename T>
+Matrix<T> Constant<T>::to_matrix() const
+{
+    return Matrix<T>(amountRows, amountColumns, constant);
+}
+
+template <typename T>
+Constant<T>::operator Matrix<T>() const
+{
+    return to_matrix();
+}
+
+template <typename T>
+Matrix<T> Constant<T>::dot(const Matrix<T> &other) const
+{
+    detail::check_inner(amountColumns, other.rows());
+    auto sums = sum(other, 0);
+    Matrix<T> res(amountRows, other.columns());
+    const T *s = sums.data();
+    T *out = res.data();
+    for(size_t i = 0; i < amountRows; ++i)
+        for(size_t j = 0; j < other.columns(); ++j)
+            out[i * other.columns() + j] = constant * s[j];
+    return res;
+}
+
+//================================================================================================
+//=========================================Identity===============================================
+//================================================================================================
+template <typename T>
+Identity<T>::Identity(size_t n_): n(n_)
+{
+
+}
+
+template <typename T>
+size_t Identity<T>::rows() const
+{
+    return n;
+}
+
+template <typename T>
+size_t Identity<T>::columns() const
+{
+    return n;
+}
+
+template <typename T>
+T Identity<T>::operator()(size_t i, size_t j) const
+{
+    detail::check_index(i, j, n, n);
+    return i == j ? T(1) : T();
+}
+
+template <typename T>
+Matrix<T> Identity<T>::to_matrix() const
+{
+    Matrix<T> res(n, n);
+    for(size_t i = 0; i < n; ++i)
+        res(i, i) = T(1);
+    return res;
+}
+
+template <typename T>
+Identity<T>::operator Matrix<T>() const
+{
+    return to_matrix();
+}
+
+template <typename T>
+Matrix<T> Identity<T>::dot(const Matrix<T> &other) const
+{
+    detail::check_inner(n, other.rows());
+    return other;
+}
+
+//================================================================================================
+//=========================================Diagonal===============================================
+//================================================================================================
+template <typename T>
+Diagonal<T>::Diagonal(std::vector<T> values_): diagonal(std::move(values_))
+{
+
+}
+
+template <typename T>
+Diagonal<T>::Diagonal(const Matrix<T> &vector): diagonal(vector.begin(), vector.end())
+{
+    if(vector.rows() != 1 && vector.columns() != 1)
+        throw std::length_error("Vector dimensions must agree");
+}
+
+template <typename T>
+size_t Diagonal<T>::rows() const
+{
+    return diagonal.size();
+}
+
+template <typename T>
+size_t Diagonal<T>::columns() const
+{
+    return diagonal.size();
+}
+
+template <typename T>
+const std::vector<T> &Diagonal<T>::values() const
+{
+    return diagonal;
+}
+
+template <typename T>
+T Diagonal<T>::operator()(size_t i, size_t j) const
+{
+    detail::check_index(i, j, diagonal.size(), diagonal.size());
+    return i == j ? diagonal[i] : T();
+}
+
+template <typename T>
+Matrix<T> Diagonal<T>::to_matrix() const
+{
+    Matrix<T> res(diagonal.size(), diagonal.size());
+    for(size_t i = 0; i < diagonal.size(); ++i)
+        res(i, i) = diagonal[i];
+    return res;
+}
+
+template <typename T>
+Diagonal<T>::operator Matrix<T>() const
+{
+    return to_matrix();
+}
+
+template <typename T>
+Matrix<T> Diagonal<T>::dot(const Matrix<T> &other) const
+{
+    detail::check_inner(diagonal.size(), other.rows());
+    size_t columns = other.columns();
+    Matrix<T> res(other.rows(), columns);
+    const T *in = other.data();
+    T *out = res.data();
+    detail::parallel_for(0, other.rows(), detail::parallel_grain(columns), [&](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i)
+            for(size_t j = 0; j < columns; ++j)
+                out[i * columns + j] = diagonal[i] * in[i * columns + j];
+    });
+    return res;
+}
+
+template <typename T>
+Diagonal<T> Diagonal<T>::dot(const Diagonal &other) const
+{
+    detail::check_inner(diagonal.size(), other.rows());
+    return *this * other;
+}
+
+//================================================================================================
+//======================================lazy arithmetic===========================================
+//================================================================================================
+template <typename T>
+Matrix<T> dot(const Matrix<T> &matrix, const Constant<T> &c)
+{
+    detail::check_inner(matrix.columns(), c.rows());
+    auto sums = sum(matrix, 1);
+    Matrix<T> res(matrix.rows(), c.columns());
+    const T *s = sums.data();
+    T *out = res.data();
+    for(size_t i = 0; i < matrix.rows(); ++i)
+        for(size_t j = 0; j < c.columns(); ++j)
+            out[i * c.columns() + j] = s[i] * c.value();
+    return res;
+}
+
+template <typename T>
+Matrix<T> dot(const Matrix<T> &matrix, const Identity<T> &identity)
+{
+    detail::check_inner(matrix.columns(), identity.rows());
+    return matrix;
+}
+
+template <typename T>
+Matrix<T> dot(const Matrix<T> &matrix, const Diagonal<T> &d)
+{
+    detail::check_inner(matrix.columns(), d.rows());
+    size_t columns = matrix.columns();
+    Matrix<T> res(matrix.rows(), columns);
+    const T *in = matrix.data();
+    const T *scale = d.values().data();
+    T *out = res.data();
+    detail::parallel_for(0, matrix.rows(), detail::parallel_grain(columns), [&](size_t b, size_t e){
+        for(size_t i = b; i < e; ++i)
+            for(size_t j = 0; j < columns; ++j)
+                out[i * columns + j] = in[i * columns + j] * scale[j];
+    });
+    return res;
+}
+
+template <typename T>
+template <typename Lazy, typename>
+Matrix<T> Matrix<T>::dot(const Lazy &lazy) const
+{
+    return matrix_view::dot(*this, lazy);
+}
+
+template <typename T, typename L>
+std::enable_if_t<is_lazy_v<L>, Matrix<T>> operator+(const Matrix<T> &matrix, const L &l)
+{
+    Matrix<T> res(matrix);
+    detail::add_lazy(res, l, T(1));
+    return res;
+}
+
+template <typename T, typename L>
+std::enable_if_t<is_lazy_v<L>, Matrix<T>> operator+(const L &l, const Matrix<T> &matrix)
+{
+    return matrix + l;
+}
+
+template <typename T, typename L>
+std::enable_if_t<is_lazy_v<L>, Matrix<T>> operator-(const Matrix<T> &matrix, const L &l)
+{
+    Matrix<T> res(matrix);
+    detail::add_lazy(res, l, T(-1));
+    return res;
+}
+
+template <typename T, typename L>
+std::enable_if_t<is_lazy_v<L>, Matrix<T>> operator-(const L &l, const Matrix<T> &matrix)
+{
+    Matrix<T> res(matrix * T(-1));
+    detail::add_lazy(res, l, T(1));
+    return res;
+}
+
+template <typename T>
+Matrix<T> operator*(const Matrix<T> &matrix, const Constant<T> &c)
+{
+    detail::check_same_shape(matrix.rows(), matrix.columns(), c.rows(), c.columns());
+    return matrix * c.value();
+}
+
+template <typename T>
+Matrix<T> operator*(const Constant<T> &c, const Matrix<T> &matrix)
+{
+    return matrix * c;
+}
+
+template <typename T>
+Diagonal<T> operator*(const Matrix<T> &matrix, const Diagonal<T> &d)
+{
+    detail::check_same_shape(matrix.rows(), matrix.columns(), d.rows(), d.columns());
+    std::vector<T> values(d.values());
+    for(size_t i = 0; i < values.size(); ++i)
+        values[i] *= matrix(i, i);
+    return Diagonal<T>(std::move(values));
+}
+
+template <typename T>
+Diagonal<T> operator*(const Diagonal<T> &d, const Matrix<T> &matrix)
+{
+    return matrix * d;
+}
+
+namespace detail{
+template <typename T, typename Operation>
+Diagonal<T> diagonal_binary(const Diagonal<T> &l, const Diagonal<T> &r, Operation oper)
+{
+    check_same_shape(l.rows(), l.columns(), r.rows(), r.columns());
+    std::vector<T> values(l.rows());
+    for(size_t i = 0; i < values.size(); ++i)
+        values[i] = oper(l.values()[i], r.values()[i]);
+    return Diagonal<T>(std::move(values));
+}
+}
+
+template <typename T>
+Diagonal<T> operator+(const Diagonal<T> &l, const Diagonal<T> &r)
+{
+    return detail::diagonal_binary(l, r, std::plus<>());
+}
+
+template <typename T>
+Diagonal<T> operator-(const Diagonal<T> &l, const Diagonal<T> &r)
+{
+    return detail::diagonal_binary(l, r, std::minus<>());
+}
+
+template <typename T>
+Diagonal<T> operator*(const Diagonal<T> &l, const Diagonal<T> &r)
+{
+    return detail::diagonal_binary(l, r, std::multiplies<>());
+}
+
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Diagonal<T>> operator*(const Diagonal<T> &d, U u)
+{
+    std::vector<T> values(d.values());
+    for(auto &value: values)
+        value *= u;
+    return Diagonal<T>(std::move(values));
+}
+
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Diagonal<T>> operator*(U u, const Diagonal<T> &d)
+{
+    return d * u;
+}
+
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Diagonal<T>> operator*(const Identity<T> &identity, U u)
+{
+    return Diagonal<T>(std::vector<T>(identity.rows(), T(u)));
+}
+
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Diagonal<T>> operator*(U u, const Identity<T> &identity)
+{
+    return identity * u;
+}
+
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Constant<T>> operator*(const Constant<T> &c, U u)
+{
+    return Constant<T>(c.rows(), c.columns(), T(c.value() * u));
+}
+
+template <typename T, typename U>
+std::enable_if_t<std::is_arithmetic_v<U>, Constant<T>> operator*(U u, const Constant<T> &c)
+{
+    return c * u;
+}
+
+}
+#endif // STRUCTURED_H
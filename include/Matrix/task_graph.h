@@ -0,0 +1,377 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace matrix_view {
+
+class TaskGraph;
+
+namespace detail{
+//node of task graph, result is released as soon as all consumers are executed
+//and there is no Lazy handle to it
+struct task_node{
+    virtual ~task_node() = default;
+    virtual void execute() = 0;
+    virtual void release() = 0;
+
+    void consumer_finished();
+    void handle_acquired();
+    void handle_released();
+    void finished();
+
+    std::vector<std::shared_ptr<task_node>> dependencies;
+    std::vector<task_node*> dependents;
+    //dependencies, which are not executed in current run
+    std::atomic<size_t> pending{0};
+    std::exception_ptr error;
+
+private:
+    void try_release();
+
+    std::mutex mutex;
+    size_t consumers = 0;
+    size_t handles = 0;
+    bool done = false;
+
+    friend class matrix_view::TaskGraph;
+};
+
+template <typename R>
+struct value_node: task_node{
+    void execute() override
+    {
+        result.emplace(func());
+        func = nullptr;
+    }
+    void release() override { result.reset(); }
+
+    std::function<R()> func;
+    std::optional<R> result;
+};
+}
+
+//handle to result of task, which is computed by TaskGraph::run
+template <typename R>
+class Lazy{
+public:
+    Lazy(const Lazy &other);
+    Lazy &operator=(const Lazy &other);
+    ~Lazy();
+
+    //result of executed task, rethrows exception of task
+    const R &get() const;
+    bool ready() const;
+
+private:
+    explicit Lazy(std::shared_ptr<detail::value_node<R>> node_);
+
+    std::shared_ptr<detail::value_node<R>> node;
+
+    friend class TaskGraph;
+};
+
+//graph of matrix operations, run() executes independent tasks concurrently
+//by work-stealing workers, tasks are added and run from one thread
+class TaskGraph{
+public:
+    //threads = 0 - all hardware threads
+    explicit TaskGraph(size_t threads_ = 0);
+
+    template <typename R>
+    Lazy<R> value(R r);
+
+    //task func(args.get()...)
+    template <typename F, typename... Args>
+    auto add(F func, const Lazy<Args>&... args) -> Lazy<std::invoke_result_t<F, const Args&...>>;
+
+    template <typename T>
+    Lazy<Matrix<T>> dot(const Lazy<Matrix<T>> &a, const Lazy<Matrix<T>> &b);
+
+    template <typename T, typename U>
+    Lazy<Matrix<T>> cat(size_t dim, const Lazy<Matrix<T>> &a, const Lazy<Matrix<U>> &b);
+
+    //execute all added tasks, rethrows the first exception of tasks
+    void run();
+
+private:
+    struct worker_queue{
+        std::mutex mutex;
+        std::deque<detail::task_node*> tasks;
+    };
+
+    void push(size_t worker, detail::task_node *node);
+    detail::task_node *pop(size_t worker);
+    void work(size_t worker);
+    void execute(size_t worker, detail::task_node *node);
+
+    size_t threads;
+    std::vector<std::shared_ptr<detail::task_node>> nodes;
+
+    //state of current run
+    std::vector<worker_queue> queues;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> remaining{0};
+    std::mutex sleepMutex;
+    std::condition_variable sleep;
+};
+
+//================================================================================================
+//=======================================task_node================================================
+//================================================================================================
+namespace detail{
+inline void task_node::try_release()
+{
+    if(done && consumers == 0 && handles == 0)
+        release();
+}
+
+inline void task_node::consumer_finished()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    --consumers;
+    try_release();
+}
+
+inline void task_node::handle_acquired()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++handles;
+}
+
+inline void task_node::handle_released()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    --handles;
+    try_release();
+}
+
+inline void task_node::finished()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    try_release();
+}
+}
+
+//================================================================================================
+//==========================================Lazy==================================================
+//================================================================================================
+template <typename R>
+Lazy<R>::Lazy(std::shared_ptr<detail::value_node<R>> node_): node(std::move(node_))
+{
+    node->handle_acquired();
+}
+
+template <typename R>
+Lazy<R>::Lazy(const Lazy &other): node(other.node)
+{
+    node->handle_acquired();
+}
+
+template <typename R>
+Lazy<R> &Lazy<R>::operator=(const Lazy &other)
+{
+    if(node == other.node)
+        return *this;
+    other.node->handle_acquired();
+    node->handle_released();
+    node = other.node;
+    return *this;
+}
+
+template <typename R>
+Lazy<R>::~Lazy()
+{
+    node->handle_released();
+}
+
+template <typename R>
+const R &Lazy<R>::get() const
+{
+    if(node->error)
+        std::rethrow_exception(node->error);
+    if(!node->result)
+        throw std::logic_error("task is not executed");
+    return *node->result;
+}
+
+template <typename R>
+bool Lazy<R>::ready() const
+{
+    return node->result.has_value();
+}
+
+//================================================================================================
+//=======================================TaskGraph================================================
+//================================================================================================
+inline TaskGraph::TaskGraph(size_t threads_):
+    threads(threads_ ? threads_ : detail::hardware_threads())
+{
+
+}
+
+template <typename R>
+Lazy<R> TaskGraph::value(R r)
+{
+    auto node = std::make_shared<detail::value_node<R>>();
+    node->result.emplace(std::move(r));
+    node->done = true;
+    return Lazy<R>(node);
+}
+
+template <typename F, typename... Args>
+auto TaskGraph::add(F func, const Lazy<Args>&... args) -> Lazy<std::invoke_result_t<F, const Args&...>>
+{
+    using R = std::invoke_result_t<F, const Args&...>;
+    auto node = std::make_shared<detail::value_node<R>>();
+    node->func = [func, deps = std::make_tuple(args.node...)]() mutable {
+        return std::apply([&func](const auto&... dep){ return func(*dep->result...); }, deps);
+    };
+    for(auto dep: {std::static_pointer_cast<detail::task_node>(args.node)...}){
+        std::lock_guard<std::mutex> lock(dep->mutex);
+        ++dep->consumers;
+        node->dependencies.push_back(dep);
+        if(!dep->done){
+            ++node->pending;
+            dep->dependents.push_back(node.get());
+        }
+    }
+    nodes.push_back(node);
+    return Lazy<R>(node);
+}
+
+template <typename T>
+Lazy<Matrix<T>> TaskGraph::dot(const Lazy<Matrix<T>> &a, const Lazy<Matrix<T>> &b)
+{
+    return add([](const Matrix<T> &l, const Matrix<T> &r){ return l.dot(r); }, a, b);
+}
+
+template <typename T, typename U>
+Lazy<Matrix<T>> TaskGraph::cat(size_t dim, const Lazy<Matrix<T>> &a, const Lazy<Matrix<U>> &b)
+{
+    return add([dim](const Matrix<T> &l, const Matrix<U> &r){ return matrix_view::cat(dim, l, r); }, a, b);
+}
+
+inline void TaskGraph::push(size_t worker, detail::task_node *node)
+{
+    {
+        std::lock_guard<std::mutex> lock(queues[worker].mutex);
+        queues[worker].tasks.push_back(node);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queued;
+    }
+    sleep.notify_one();
+}
+
+//own tasks are taken from back (the last pushed is hot in cache), others are stolen from front
+inline detail::task_node *TaskGraph::pop(size_t worker)
+{
+    for(size_t i = 0; i < queues.size(); ++i){
+        auto &queue = queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.tasks.empty())
+            continue;
+        detail::task_node *node;
+        if(i == 0){
+            node = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        else{
+            node = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        --queued;
+        return node;
+    }
+    return nullptr;
+}
+
+inline void TaskGraph::execute(size_t worker, detail::task_node *node)
+{
+    for(auto &dep: node->dependencies)
+        if(dep->error && !node->error)
+            node->error = dep->error;
+    if(!node->error){
+        //kernels of the task use threads, if there is no other ready task
+        bool nested = detail::in_parallel;
+        detail::in_parallel = queued > 0;
+        try{
+            node->execute();
+        }
+        catch(...){
+            node->error = std::current_exception();
+        }
+        detail::in_parallel = nested;
+    }
+    node->finished();
+    for(auto &dep: node->dependencies)
+        dep->consumer_finished();
+    node->dependencies.clear();
+    for(auto dependent: node->dependents)
+        if(--dependent->pending == 0)
+            push(worker, dependent);
+    node->dependents.clear();
+
+    if(--remaining == 0){
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        sleep.notify_all();
+    }
+}
+
+inline void TaskGraph::work(size_t worker)
+{
+    while(remaining > 0){
+        if(auto node = pop(worker)){
+            execute(worker, node);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleep.wait(lock, [this](){ return queued > 0 || remaining == 0; });
+    }
+}
+
+inline void TaskGraph::run()
+{
+    if(nodes.empty())
+        return;
+    auto current = std::move(nodes);
+    nodes.clear();
+
+    size_t workers = std::min(threads, current.size());
+    queues = std::vector<worker_queue>(workers);
+    queued = 0;
+    remaining = current.size();
+    size_t next = 0;
+    for(auto &node: current)
+        if(node->pending == 0)
+            push(next++ % workers, node.get());
+
+    std::vector<std::thread> pool;
+    for(size_t i = 1; i < workers; ++i)
+        pool.emplace_back([this, i](){ work(i); });
+    work(0);
+    for(auto &thread: pool)
+        thread.join();
+
+    for(auto &node: current)
+        if(node->error)
+            std::rethrow_exception(node->error);
+}
+
+}
+#endif // TASK_GRAPH_H
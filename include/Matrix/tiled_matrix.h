@@ -0,0 +1,571 @@
+#ifndef TILED_MATRIX_H
+#define TILED_MATRIX_H
+
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace matrix_view {
+
+//disk-backed matrix, which is stored by square tiles (tile x tile, edge tiles are padded by 0),
+//at most cacheTiles tiles are kept in memory (LRU), dirty tiles are written on eviction or flush
+template <typename T>
+class TiledMatrix{
+public:
+    static_assert (std::is_arithmetic_v<T>, "Type must be arithmetic");
+
+    //create new file
+    TiledMatrix(const std::string &path_, size_t amountRows_, size_t amountColumns_,
+                size_t tile_ = 1024, size_t cacheTiles_ = 16);
+    TiledMatrix(TiledMatrix &&other) noexcept;
+    TiledMatrix &operator=(TiledMatrix &&other) noexcept;
+    TiledMatrix(const TiledMatrix &other) = delete;
+    TiledMatrix &operator=(const TiledMatrix &other) = delete;
+    ~TiledMatrix();
+
+    //open existing file
+    static TiledMatrix open(const std::string &path, size_t cacheTiles = 16);
+    static TiledMatrix from_matrix(const std::string &path, const Matrix<T> &matrix,
+                                   size_t tile = 1024, size_t cacheTiles = 16);
+
+    size_t rows() const;
+    size_t columns() const;
+    size_t tile_size() const;
+    //amount of tiles along rows and columns
+    size_t tile_rows() const;
+    size_t tile_columns() const;
+    const std::string &path() const;
+
+    T get(size_t i, size_t j);
+    void set(size_t i, size_t j, T value);
+
+    //tile (ti, tj), tile x tile matrix
+    Matrix<T> read_tile(size_t ti, size_t tj);
+    void write_tile(size_t ti, size_t tj, const Matrix<T> &tileMatrix);
+
+    //write dirty tiles of cache
+    void flush();
+    Matrix<T> to_matrix();
+
+    //direct access to file, cache must be flushed before
+    void read_raw(size_t ti, size_t tj, T *out) const;
+    void write_raw(size_t ti, size_t tj, const T *in) const;
+
+private:
+    TiledMatrix() = default;
+
+    struct cache_entry{
+        std::vector<T> data;
+        bool dirty;
+        std::list<size_t>::iterator position;
+    };
+
+    std::vector<T> &cached(size_t ti, size_t tj);
+    void evict();
+    void clear_padding(size_t ti, size_t tj, T *data) const;
+    void close();
+
+    static constexpr uint64_t magic = 0x5852544d;  //"MTRX"
+    static constexpr off_t headerSize = 64;
+
+    int fd = -1;
+    std::string filePath;
+    size_t amountRows = 0;
+    size_t amountColumns = 0;
+    size_t tile = 0;
+    size_t cacheTiles = 0;
+
+    std::mutex mutex;
+    std::list<size_t> lru;
+    std::unordered_map<size_t, cache_entry> cache;
+};
+
+//out-of-core operations, inputs are streamed by tiles with read-ahead of the next tiles,
+//while the current tiles are computed, result tiles are written asynchronously
+template <typename T>
+TiledMatrix<T> dot(TiledMatrix<T> &a, TiledMatrix<T> &b, const std::string &path, size_t cacheTiles = 16);
+
+template <typename T>
+TiledMatrix<T> transpose(TiledMatrix<T> &a, const std::string &path, size_t cacheTiles = 16);
+
+//element-wise oper(a) and oper(a, b)
+template <typename T, typename Operation>
+TiledMatrix<T> transform(TiledMatrix<T> &a, const std::string &path, Operation oper, size_t cacheTiles = 16);
+
+template <typename T, typename Operation>
+TiledMatrix<T> transform(TiledMatrix<T> &a, TiledMatrix<T> &b, const std::string &path,
+                         Operation oper, size_t cacheTiles = 16);
+
+//================================================================================================
+//=======================================TiledMatrix==============================================
+//================================================================================================
+template <typename T>
+TiledMatrix<T>::TiledMatrix(const std::string &path_, size_t amountRows_, size_t amountColumns_,
+                            size_t tile_, size_t cacheTiles_):
+    filePath(path_), amountRows(amountRows_), amountColumns(amountColumns_),
+    tile(tile_), cacheTiles(std::max<size_t>(cacheTiles_, 1))
+{
+    if(tile == 0)
+        throw std::logic_error("tile size must be positive");
+    fd = ::open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        throw std::runtime_error("cannot open file " + filePath);
+    uint64_t header[8] = {magic, amountRows, amountColumns, tile, sizeof(T)};
+    off_t size = headerSize + off_t(tile_rows() * tile_columns() * tile * tile * sizeof(T));
+    if(::pwrite(fd, header, sizeof(header), 0) != sizeof(header) || ::ftruncate(fd, size) != 0){
+        close();
+        throw std::runtime_error("cannot write file " + filePath);
+    }
+}
+
+template <typename T>
+TiledMatrix<T>::TiledMatrix(TiledMatrix &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+template <typename T>
+TiledMatrix<T> &TiledMatrix<T>::operator=(TiledMatrix &&other) noexcept
+{
+    if(this == &other)
+        return *this;
+    close();
+    fd = other.fd;
+    filePath = std::move(other.filePath);
+    amountRows = other.amountRows;
+    amountColumns = other.amountColumns;
+    tile = other.tile;
+    cacheTiles = other.cacheTiles;
+    lru = std::move(other.lru);
+    cache = std::move(other.cache);
+    other.fd = -1;
+    return *this;
+}
+
+template <typename T>
+TiledMatrix<T>::~TiledMatrix()
+{
+    close();
+}
+
+template <typename T>
+void TiledMatrix<T>::close()
+{
+    if(fd < 0)
+        return;
+    try{
+        flush();
+    }
+    catch(...){
+    }
+    ::close(fd);
+    fd = -1;
+}
+
+template <typename T>
+TiledMatrix<T> TiledMatrix<T>::open(const std::string &path, size_t cacheTiles)
+{
+    TiledMatrix<T> m;
+    m.fd = ::open(path.c_str(), O_RDWR);
+    if(m.fd < 0)
+        throw std::runtime_error("cannot open file " + path);
+    uint64_t header[8];
+    if(::pread(m.fd, header, sizeof(header), 0) != sizeof(header) || header[0] != magic)
+        throw std::runtime_error("file is not tiled matrix " + path);
+    if(header[4] != sizeof(T))
+        throw std::runtime_error("type of tiled matrix doesn't match " + path);
+    m.filePath = path;
+    m.amountRows = header[1];
+    m.amountColumns = header[2];
+    m.tile = header[3];
+    m.cacheTiles = std::max<size_t>(cacheTiles, 1);
+    return m;
+}
+
+template <typename T>
+TiledMatrix<T> TiledMatrix<T>::from_matrix(const std::string &path, const Matrix<T> &matrix,
+                                           size_t tile, size_t cacheTiles)
+{
+    TiledMatrix<T> m(path, matrix.rows(), matrix.columns(), tile, cacheTiles);
+    std::vector<T> buffer(tile * tile);
+    for(size_t ti = 0; ti < m.tile_rows(); ++ti){
+        for(size_t tj = 0; tj < m.tile_columns(); ++tj){
+            std::fill(buffer.begin(), buffer.end(), T());
+            size_t rows = std::min(tile, matrix.rows() - ti * tile);
+            size_t columns = std::min(tile, matrix.columns() - tj * tile);
+            for(size_t i = 0; i < rows; ++i){
+                auto row = matrix.begin_row(ti * tile + i) + tj * tile;
+                std::copy(row, row + columns, buffer.begin() + i * tile);
+            }
+            m.write_raw(ti, tj, buffer.data());
+        }
+    }
+    return m;
+}
+
+template <typename T>
+size_t TiledMatrix<T>::rows() const
+{
+    return amountRows;
+}
+
+template <typename T>
+size_t TiledMatrix<T>::columns() const
+{
+    return amountColumns;
+}
+
+template <typename T>
+size_t TiledMatrix<T>::tile_size() const
+{
+    return tile;
+}
+
+template <typename T>
+size_t TiledMatrix<T>::tile_rows() const
+{
+    return (amountRows + tile - 1) / tile;
+}
+
+template <typename T>
+size_t TiledMatrix<T>::tile_columns() const
+{
+    return (amountColumns + tile - 1) / tile;
+}
+
+template <typename T>
+const std::string &TiledMatrix<T>::path() const
+{
+    return filePath;
+}
+
+template <typename T>
+void TiledMatrix<T>::read_raw(size_t ti, size_t tj, T *out) const
+{
+    size_t bytes = tile * tile * sizeof(T);
+    off_t offset = headerSize + off_t((ti * tile_columns() + tj) * bytes);
+    for(size_t done = 0; done < bytes;){
+        auto n = ::pread(fd, reinterpret_cast<char*>(out) + done, bytes - done, offset + off_t(done));
+        if(n <= 0)
+            throw std::runtime_error("cannot read file " + filePath);
+        done += size_t(n);
+    }
+}
+
+template <typename T>
+void TiledMatrix<T>::write_raw(size_t ti, size_t tj, const T *in) const
+{
+    //padding of edge tile is cleared in a copy, buffer of caller is not changed
+    ScratchScope scope;
+    if((ti + 1) * tile > amountRows || (tj + 1) * tile > amountColumns){
+        T *padded = scope.allocate<T>(tile * tile);
+        std::copy(in, in + tile * tile, padded);
+        clear_padding(ti, tj, padded);
+        in = padded;
+    }
+    size_t bytes = tile * tile * sizeof(T);
+    off_t offset = headerSize + off_t((ti * tile_columns() + tj) * bytes);
+    for(size_t done = 0; done < bytes;){
+        auto n = ::pwrite(fd, reinterpret_cast<const char*>(in) + done, bytes - done, offset + off_t(done));
+        if(n <= 0)
+            throw std::runtime_error("cannot write file " + filePath);
+        done += size_t(n);
+    }
+}
+
+//elements outside of matrix stay 0, so edge tiles can be multiplied as full tiles
+template <typename T>
+void TiledMatrix<T>::clear_padding(size_t ti, size_t tj, T *data) const
+{
+    size_t rows = std::min(tile, amountRows - ti * tile);
+    size_t columns = std::min(tile, amountColumns - tj * tile);
+    if(columns < tile)
+        for(size_t i = 0; i < rows; ++i)
+            std::fill(data + i * tile + columns, data + (i + 1) * tile, T());
+    std::fill(data + rows * tile, data + tile * tile, T());
+}
+
+template <typename T>
+void TiledMatrix<T>::evict()
+{
+    size_t key = lru.back();
+    auto &entry = cache.at(key);
+    if(entry.dirty)
+        write_raw(key / tile_columns(), key % tile_columns(), entry.data.data());
+    lru.pop_back();
+    cache.erase(key);
+}
+
+template <typename T>
+std::vector<T> &TiledMatrix<T>::cached(size_t ti, size_t tj)
+{
+    size_t key = ti * tile_columns() + tj;
+    auto it = cache.find(key);
+    if(it != cache.end()){
+        lru.splice(lru.begin(), lru, it->second.position);
+        return it->second.data;
+    }
+    while(cache.size() >= cacheTiles)
+        evict();
+    std::vector<T> data(tile * tile);
+    read_raw(ti, tj, data.data());
+    lru.push_front(key);
+    auto &entry = cache[key];
+    entry = {std::move(data), false, lru.begin()};
+    return entry.data;
+}
+
+template <typename T>
+T TiledMatrix<T>::get(size_t i, size_t j)
+{
+    if(i >= amountRows || j >= amountColumns)
+        throw std::out_of_range("Index exceeds matrix dimensions.");
+    std::lock_guard<std::mutex> lock(mutex);
+    return cached(i / tile, j / tile)[(i % tile) * tile + j % tile];
+}
+
+template <typename T>
+void TiledMatrix<T>::set(size_t i, size_t j, T value)
+{
+    if(i >= amountRows || j >= amountColumns)
+        throw std::out_of_range("Index exceeds matrix dimensions.");
+    std::lock_guard<std::mutex> lock(mutex);
+    cached(i / tile, j / tile)[(i % tile) * tile + j % tile] = value;
+    cache.at((i / tile) * tile_columns() + j / tile).dirty = true;
+}
+
+template <typename T>
+Matrix<T> TiledMatrix<T>::read_tile(size_t ti, size_t tj)
+{
+    if(ti >= tile_rows() || tj >= tile_columns())
+        throw std::out_of_range("Index exceeds matrix dimensions.");
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &data = cached(ti, tj);
+    return Matrix<T>(tile, tile, data.begin(), data.end());
+}
+
+template <typename T>
+void TiledMatrix<T>::write_tile(size_t ti, size_t tj, const Matrix<T> &tileMatrix)
+{
+    if(ti >= tile_rows() || tj >= tile_columns())
+        throw std::out_of_range("Index exceeds matrix dimensions.");
+    if(tileMatrix.rows() != tile || tileMatrix.columns() != tile)
+        throw std::runtime_error("Matrix dimensions must agree");
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &data = cached(ti, tj);
+    std::copy(tileMatrix.begin(), tileMatrix.end(), data.begin());
+    clear_padding(ti, tj, data.data());
+    cache.at(ti * tile_columns() + tj).dirty = true;
+}
+
+template <typename T>
+void TiledMatrix<T>::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto &[key, entry]: cache){
+        if(entry.dirty){
+            write_raw(key / tile_columns(), key % tile_columns(), entry.data.data());
+            entry.dirty = false;
+        }
+    }
+}
+
+template <typename T>
+Matrix<T> TiledMatrix<T>::to_matrix()
+{
+    flush();
+    Matrix<T> m(amountRows, amountColumns);
+    std::vector<T> buffer(tile * tile);
+    for(size_t ti = 0; ti < tile_rows(); ++ti){
+        for(size_t tj = 0; tj < tile_columns(); ++tj){
+            read_raw(ti, tj, buffer.data());
+            size_t rows = std::min(tile, amountRows - ti * tile);
+            size_t columns = std::min(tile, amountColumns - tj * tile);
+            for(size_t i = 0; i < rows; ++i)
+                std::copy(buffer.begin() + i * tile, buffer.begin() + i * tile + columns,
+                          m.begin_row(ti * tile + i) + tj * tile);
+        }
+    }
+    return m;
+}
+
+//================================================================================================
+//==================================out-of-core operations========================================
+//================================================================================================
+namespace detail{
+//step s: inputs of step s + 1 are read by load(s + 1) asynchronously, while compute(s, inputs) runs
+template <typename Load, typename Compute>
+void tile_pipeline(size_t steps, Load load, Compute compute)
+{
+    if(steps == 0)
+        return;
+    auto next = std::async(std::launch::async, load, size_t(0));
+    for(size_t s = 0; s < steps; ++s){
+        auto current = next.get();
+        if(s + 1 < steps)
+            next = std::async(std::launch::async, load, s + 1);
+        compute(s, current);
+    }
+}
+
+//writes result tiles in background, the previous write is finished before the next one
+template <typename T>
+class tile_writer{
+public:
+    explicit tile_writer(TiledMatrix<T> &out_): out(out_), buffer(out_.tile_size() * out_.tile_size()) {}
+    ~tile_writer()
+    {
+        if(pending.valid())
+            pending.wait();
+    }
+
+    void write(size_t ti, size_t tj, const T *data)
+    {
+        finish();
+        std::copy(data, data + buffer.size(), buffer.begin());
+        pending = std::async(std::launch::async, [this, ti, tj](){ out.write_raw(ti, tj, buffer.data()); });
+    }
+
+    void finish()
+    {
+        if(pending.valid())
+            pending.get();
+    }
+
+private:
+    TiledMatrix<T> &out;
+    std::vector<T> buffer;
+    std::future<void> pending;
+};
+
+template <typename T>
+std::vector<T> read_tile_raw(const TiledMatrix<T> &m, size_t ti, size_t tj)
+{
+    std::vector<T> data(m.tile_size() * m.tile_size());
+    m.read_raw(ti, tj, data.data());
+    return data;
+}
+}
+
+template <typename T>
+TiledMatrix<T> dot(TiledMatrix<T> &a, TiledMatrix<T> &b, const std::string &path, size_t cacheTiles)
+{
+    if(a.columns() != b.rows())
+        throw std::length_error("Inner matrix dimensions must agree");
+    if(a.tile_size() != b.tile_size())
+        throw std::logic_error("tile sizes must agree");
+    a.flush();
+    b.flush();
+    size_t tile = a.tile_size();
+    TiledMatrix<T> res(path, a.rows(), b.columns(), tile, cacheTiles);
+    size_t inner = a.tile_columns(), columns = b.tile_columns();
+    //result of product with empty inner dimension is 0
+    if(inner == 0)
+        return res;
+    std::vector<T> accumulator(tile * tile);
+    detail::tile_writer<T> writer(res);
+
+    //step = (i, j, k), C(i, j) += A(i, k) * B(k, j)
+    auto load = [&a, &b, inner, columns](size_t s){
+        size_t k = s % inner, j = (s / inner) % columns, i = s / inner / columns;
+        return std::make_pair(detail::read_tile_raw(a, i, k), detail::read_tile_raw(b, k, j));
+    };
+    auto compute = [&](size_t s, const std::pair<std::vector<T>, std::vector<T>> &tiles){
+        size_t k = s % inner, j = (s / inner) % columns, i = s / inner / columns;
+        detail::block_view<const T> at{tiles.first.data(), tile, tile, tile};
+        detail::block_view<const T> bt{tiles.second.data(), tile, tile, tile};
+        detail::gemm(at, bt, detail::block_view<T>{accumulator.data(), tile, tile, tile}, k != 0);
+        if(k + 1 == inner)
+            writer.write(i, j, accumulator.data());
+    };
+    detail::tile_pipeline(a.tile_rows() * columns * inner, load, compute);
+    writer.finish();
+    return res;
+}
+
+template <typename T>
+TiledMatrix<T> transpose(TiledMatrix<T> &a, const std::string &path, size_t cacheTiles)
+{
+    a.flush();
+    size_t tile = a.tile_size(), columns = a.tile_columns();
+    TiledMatrix<T> res(path, a.columns(), a.rows(), tile, cacheTiles);
+    std::vector<T> transposed(tile * tile);
+    detail::tile_writer<T> writer(res);
+    auto load = [&a, columns](size_t s){
+        return detail::read_tile_raw(a, s / columns, s % columns);
+    };
+    auto compute = [&](size_t s, const std::vector<T> &data){
+        for(size_t i = 0; i < tile; ++i)
+            for(size_t j = 0; j < tile; ++j)
+                transposed[j * tile + i] = data[i * tile + j];
+        writer.write(s % columns, s / columns, transposed.data());
+    };
+    detail::tile_pipeline(a.tile_rows() * columns, load, compute);
+    writer.finish();
+    return res;
+}
+
+template <typename T, typename Operation>
+TiledMatrix<T> transform(TiledMatrix<T> &a, const std::string &path, Operation oper, size_t cacheTiles)
+{
+    a.flush();
+    size_t columns = a.tile_columns();
+    TiledMatrix<T> res(path, a.rows(), a.columns(), a.tile_size(), cacheTiles);
+    detail::tile_writer<T> writer(res);
+    auto load = [&a, columns](size_t s){
+        return detail::read_tile_raw(a, s / columns, s % columns);
+    };
+    auto compute = [&](size_t s, std::vector<T> &data){
+        detail::parallel_for(0, data.size(), detail::parallel_threshold, [&](size_t b, size_t e){
+            for(size_t i = b; i < e; ++i)
+                data[i] = oper(data[i]);
+        });
+        writer.write(s / columns, s % columns, data.data());
+    };
+    detail::tile_pipeline(a.tile_rows() * columns, load, compute);
+    writer.finish();
+    return res;
+}
+
+template <typename T, typename Operation>
+TiledMatrix<T> transform(TiledMatrix<T> &a, TiledMatrix<T> &b, const std::string &path,
+                         Operation oper, size_t cacheTiles)
+{
+    if(a.rows() != b.rows() || a.columns() != b.columns())
+        throw std::runtime_error("Matrix dimensions must agree");
+    if(a.tile_size() != b.tile_size())
+        throw std::logic_error("tile sizes must agree");
+    a.flush();
+    b.flush();
+    size_t columns = a.tile_columns();
+    TiledMatrix<T> res(path, a.rows(), a.columns(), a.tile_size(), cacheTiles);
+    detail::tile_writer<T> writer(res);
+    auto load = [&a, &b, columns](size_t s){
+        return std::make_pair(detail::read_tile_raw(a, s / columns, s % columns),
+                              detail::read_tile_raw(b, s / columns, s % columns));
+    };
+    auto compute = [&](size_t s, std::pair<std::vector<T>, std::vector<T>> &tiles){
+        auto &l = tiles.first;
+        const auto &r = tiles.second;
+        detail::parallel_for(0, l.size(), detail::parallel_threshold, [&](size_t b, size_t e){
+            for(size_t i = b; i < e; ++i)
+                l[i] = oper(l[i], r[i]);
+        });
+        writer.write(s / columns, s % columns, l.data());
+    };
+    detail::tile_pipeline(a.tile_rows() * columns, load, compute);
+    writer.finish();
+    return res;
+}
+
+}
+#endif // TILED_MATRIX_H
@@ -8,8 +8,12 @@
 #include <regex>
 #include <cmath>
 #include <functional>
+#include <cstdint>
 
 #include <Matrix/helper.h>
+#include <Matrix/parallel.h>
+#include <Matrix/arena.h>
+#include <Matrix/gemm.h>
 
 
 namespace  matrix_view{
@@ -53,6 +57,16 @@ private:
     InputIterator currentIter;
 };
 
+class MatrixMask;
+template <typename T>
+class MaskedView;
+template <typename T>
+struct is_lazy;
+
+//exact det and rank of integer matrices: Bareiss elimination with wide intermediates,
+//Auto falls back to multi-modular elimination, when they overflow
+enum class ExactMethod{ Auto, Bareiss, Modular };
+
 //-----------------------------MATRIX-----------------------------------------
 template<typename T>
 class Matrix{
@@ -78,10 +92,27 @@ public:
 
     Matrix &operator=(const Matrix &other);
     Matrix &operator=(Matrix &&other) noexcept;
+    void swap(Matrix &other) noexcept;
 
     size_t rows() const;
     size_t columns() const;
 
+    //storage for rows x columns elements, columns = 0 keeps current columns;
+    //capacity is amount of rows, which fit storage without reallocation
+    void reserve(size_t rows_, size_t columns_ = 0);
+    size_t capacity() const;
+    //appends rows at the end, storage grows geometrically; empty matrix takes columns of the first row
+    void append_row(const T* row, size_t n);
+    template <typename Range>
+    void append_row(const Range& row);
+    void append_row(std::initializer_list<T> row);
+    template <typename U>
+    void append_rows(const Matrix<U>& other);
+    //the same elements in row-major order as rows_ x columns_ matrix, no elements are moved
+    void reshape(size_t rows_, size_t columns_);
+    //releases storage, which is not used by elements
+    void shrink_to_fit();
+
     //access to elements
     decltype(auto) operator()(size_t i,size_t j) const;
     decltype(auto) operator()(size_t i, size_t j);
@@ -113,15 +144,26 @@ public:
     auto cbegin_column(size_t n) const;
     auto cend_column(size_t n) const;
 
+    //pointer to contiguous row-major storage
+    T* data();
+    const T* data() const;
+
     //Linear algebra
-    //determinant
-    T det() const;
-    //matrix multiplies
-    Matrix dot(const Matrix &other) const;
+    //determinant, exact for integer T: throws std::overflow_error, if it does not fit T
+    T det(ExactMethod method = ExactMethod::Auto) const;
+    //rank, exact for integer T, floating T uses elimination with tolerance
+    size_t rank(ExactMethod method = ExactMethod::Auto) const;
+    //matrix multiplies, Product::Strassen is faster for very large matrices,
+    //but floating results have a bit larger rounding error
+    Matrix dot(const Matrix &other, Product mode = Product::Blocked) const;
+    //product with Constant, Identity or Diagonal, which are not expanded to dense matrices
+    template <typename Lazy, typename = std::enable_if_t<is_lazy<Lazy>::value>>
+    Matrix dot(const Lazy &lazy) const;
     //transpose
     void transpose();
 
-    //do operation itself
+    //do operation itself, Matrix item may be 1xC row, Rx1 column or 1x1,
+    //then it's broadcast without temporary matrix
     template <typename Item, typename Operation>
     Matrix &doOperItself(const Item &item, Operation oper);
 
@@ -139,17 +181,25 @@ public:
 
     //logic operations
     template <typename Tp>
-    bool operator==(const Matrix<Tp>& other);
+    bool operator==(const Matrix<Tp>& other) const;
     template <typename Tp>
-    bool operator!=(const Matrix<Tp>& other);
+    bool operator!=(const Matrix<Tp>& other) const;
+
+    //elements selected by mask of the same shape: m[m > 5] = 0
+    MaskedView<T> operator[](MatrixMask mask);
 
 
 private:
     //parse rangeExpression
     static void parseSliceExpression(const std::string &str, size_t &range1,
                                      size_t &range2,const size_t &end);
+    //checks columns of appended rows and grows storage
+    void prepare_append(size_t columns_, size_t elements);
+    //elements or objects they refer to are in storage of this matrix
+    template <typename Iterator>
+    bool stored_here(Iterator first, Iterator last) const;
 private:
-    std::vector<T> vector;
+    std::vector<T, detail::default_init_allocator<T>> vector;
     size_t amountRows;
     size_t amountColumns;
 };
@@ -157,6 +207,10 @@ private:
 
 
 //-------------------------not member functions-----------------------------------------
+//oper(t(i,j), u(i,j)) in one pass, each dimension of t and u must agree or be 1
+template <typename T, typename U, typename Operation>
+Matrix<type_is_t<T>> broadcast(const Matrix<T>& t, const Matrix<U>& u, Operation oper);
+
 //do poperation on Matrix and arithmeric type (Matrix)
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //if left type is Matrix, right Matrix or arithmetic type
@@ -190,6 +244,77 @@ inline std::enable_if_t<is_matrix_v<T>, Matrix<type_is_t<T>>> operator*(T t, U u
 template <typename T, typename U>
 inline std::enable_if_t<std::is_arithmetic_v<T> & is_matrix_v<U>,Matrix<type_is_t<T>>> operator*(T t, U u);
 
+//------------------Matrix power------------------
+//matrix^k by repeated squaring, O(log k) products
+template <typename T>
+Matrix<T> matrix_power(const Matrix<T>& matrix, unsigned long long k);
+//matrix^k * vectors, columns of vectors are vectors
+template <typename T>
+Matrix<T> matrix_power(const Matrix<T>& matrix, unsigned long long k, const Matrix<T>& vectors);
+
+//------------------Matrix-vector operations------------------
+//x and y are vectors: 1xN or Nx1 matrices
+//y = alpha * A x + beta * y
+template <typename T>
+void gemv(T alpha, const Matrix<T>& a, const Matrix<T>& x, T beta, Matrix<T>& y);
+//y = alpha * A^T x + beta * y
+template <typename T>
+void gemv_transposed(T alpha, const Matrix<T>& a, const Matrix<T>& x, T beta, Matrix<T>& y);
+//A += alpha * x y^T
+template <typename T>
+void rank1_update(Matrix<T>& a, T alpha, const Matrix<T>& x, const Matrix<T>& y);
+
+//------------------Element-wise kernels------------------
+//all inputs must have the same shape, func is called for elements of inputs with the same index,
+//elements are processed in parallel
+//new matrix func(a(i,j), b(i,j), ...)
+template <typename Function, typename T, typename... Ts>
+auto map(Function func, const Matrix<T>& matrix, const Matrix<Ts>&... rest)
+    -> Matrix<std::decay_t<std::invoke_result_t<Function, type_is_t<T>, type_is_t<Ts>...>>>;
+//out(i,j) = func(a(i,j), b(i,j), ...), out may be one of inputs
+template <typename R, typename Function, typename T, typename... Ts>
+Matrix<R>& map_to(Matrix<R>& out, Function func, const Matrix<T>& matrix, const Matrix<Ts>&... rest);
+template <typename Function, typename T, typename U>
+auto zip_with(Function func, const Matrix<T>& t, const Matrix<U>& u);
+//init reduced with map(a(i,j), b(i,j), ...) of all elements, reduce must be associative
+template <typename Acc, typename Map, typename Reduce, typename T, typename... Ts>
+Acc map_reduce(Map map, Reduce reduce, Acc init, const Matrix<T>& matrix, const Matrix<Ts>&... rest);
+
+//------------------Index gather/scatter------------------
+//rows (columns) of matrix with given indices in given order, indices may repeat
+template <typename T>
+Matrix<type_is_t<T>> take_rows(const Matrix<T>& matrix, const std::vector<size_t>& indices);
+template <typename T>
+Matrix<type_is_t<T>> take_cols(const Matrix<T>& matrix, const std::vector<size_t>& indices);
+//row indices[k] of matrix = row k of rows, the last one wins for repeated indices
+template <typename T, typename U>
+void put_rows(Matrix<T>& matrix, const std::vector<size_t>& indices, const Matrix<U>& rows);
+
+//------------------Sorting and selection------------------
+//equal values keep order of their indices
+enum class Order{ Ascending, Descending };
+
+//k selected values of every row (column) in sorted order and their column (row) indices
+template <typename T>
+struct TopK{
+    Matrix<T> values;
+    Matrix<size_t> indices;
+};
+
+template <typename T>
+Matrix<type_is_t<T>> sort_rows(const Matrix<T>& matrix, Order order = Order::Ascending);
+template <typename T>
+Matrix<type_is_t<T>> sort_cols(const Matrix<T>& matrix, Order order = Order::Ascending);
+template <typename T>
+Matrix<size_t> argsort_rows(const Matrix<T>& matrix, Order order = Order::Ascending);
+template <typename T>
+Matrix<size_t> argsort_cols(const Matrix<T>& matrix, Order order = Order::Ascending);
+//k largest (Descending) or smallest (Ascending) elements: Rxk for rows, kxC for columns
+template <typename T>
+TopK<type_is_t<T>> topk_rows(const Matrix<T>& matrix, size_t k, Order order = Order::Descending);
+template <typename T>
+TopK<type_is_t<T>> topk_cols(const Matrix<T>& matrix, size_t k, Order order = Order::Descending);
+
 template <typename T, typename UnaryOperation>
 Matrix<type_is_t<T>> doUnaryOperation(const Matrix<T>& matrix, UnaryOperation oper);
 
@@ -233,10 +358,27 @@ inline auto floor(const Matrix<T>& matrix);
 
 template <typename T, typename U>
 inline auto pow(const Matrix<T>& matrix, U up);
+//integer exponent known at compile time, computed by multiplications
+template <int N, typename T>
+Matrix<type_is_t<T>> pow(const Matrix<T>& matrix);
 
 //------------------Create Matrix----------------------
+//seed for random matrices, different on every call
+inline uint64_t random_seed();
+
+//integer values in [min, max), the same seed gives the same matrix for any amount of threads
 template <typename T>
 Matrix<T> make_random_matrix(size_t rows, size_t columns, int min, int max);
+template <typename T>
+Matrix<T> make_random_matrix(size_t rows, size_t columns, int min, int max, uint64_t seed);
+
+//uniform real values in [low, high)
+template <typename T>
+Matrix<T> make_uniform_matrix(size_t rows, size_t columns, T low, T high, uint64_t seed);
+
+//normal distribution
+template <typename T>
+Matrix<T> make_normal_matrix(size_t rows, size_t columns, T mean, T stddev, uint64_t seed);
 
 template <typename T>
 Matrix<T> make_ones_matrix(size_t rows, size_t columns);
@@ -244,6 +386,72 @@ Matrix<T> make_ones_matrix(size_t rows, size_t columns);
 template <typename T>
 Matrix<T> make_zeros_matrix(size_t rows, size_t columns);
 
+//------------------Reductions----------------------
+//axis = 0 - along columns (result 1xC), 1 - along rows (result Rx1)
+enum class Norm{ L1, L2, Inf };
+
+template <typename T>
+type_is_t<T> sum(const Matrix<T>& matrix);
+template <typename T>
+Matrix<type_is_t<T>> sum(const Matrix<T>& matrix, size_t axis);
+
+template <typename T>
+real_type_t<T> mean(const Matrix<T>& matrix);
+template <typename T>
+Matrix<real_type_t<T>> mean(const Matrix<T>& matrix, size_t axis);
+
+template <typename T>
+type_is_t<T> min(const Matrix<T>& matrix);
+template <typename T>
+Matrix<type_is_t<T>> min(const Matrix<T>& matrix, size_t axis);
+
+template <typename T>
+type_is_t<T> max(const Matrix<T>& matrix);
+template <typename T>
+Matrix<type_is_t<T>> max(const Matrix<T>& matrix, size_t axis);
+
+//index in row-major order
+template <typename T>
+size_t argmin(const Matrix<T>& matrix);
+template <typename T>
+Matrix<size_t> argmin(const Matrix<T>& matrix, size_t axis);
+
+template <typename T>
+size_t argmax(const Matrix<T>& matrix);
+template <typename T>
+Matrix<size_t> argmax(const Matrix<T>& matrix, size_t axis);
+
+//element-wise vector norm
+template <typename T>
+real_type_t<T> norm(const Matrix<T>& matrix, Norm ord = Norm::L2);
+template <typename T>
+Matrix<real_type_t<T>> norm(const Matrix<T>& matrix, size_t axis, Norm ord = Norm::L2);
+
+//------------------Gram and covariance----------------------
+//rows of x are observations, columns are variables; only one triangle is computed,
+//rows of x are read once, centering is done on the fly
+//x^T x
+template <typename T>
+Matrix<type_is_t<T>> gram(const Matrix<T>& x);
+//ddof = 1 - sample covariance, ddof = 0 - population covariance
+template <typename T>
+Matrix<real_type_t<T>> covariance(const Matrix<T>& x, size_t ddof = 1);
+template <typename T>
+Matrix<real_type_t<T>> correlation(const Matrix<T>& x);
+
+//------------------2D convolution----------------------
+//Full - all overlaps, Same - size of image (center of Full), Valid - kernel lies inside image
+enum class ConvMode{ Full, Same, Valid };
+//Auto chooses method by kernel size: direct for small, im2col + GEMV for medium, FFT for large
+enum class ConvMethod{ Auto, Direct, Im2col, FFT };
+
+template <typename T>
+Matrix<type_is_t<T>> conv2d(const Matrix<T>& image, const Matrix<T>& kernel,
+                            ConvMode mode = ConvMode::Full, ConvMethod method = ConvMethod::Auto);
+template <typename T>
+Matrix<type_is_t<T>> correlate2d(const Matrix<T>& image, const Matrix<T>& kernel,
+                                 ConvMode mode = ConvMode::Full, ConvMethod method = ConvMethod::Auto);
+
 //-----------output matrix to ostream
 template<typename T>
 std::ostream &operator<<(std::ostream &os, const Matrix<T> &matrix);
@@ -253,5 +461,23 @@ std::ostream &operator<<(std::ostream &os, const Matrix<T> &matrix);
 }
 
 #include <Matrix/matrix_impl.h>
+#include <Matrix/reduction.h>
+#include <Matrix/gram.h>
+#include <Matrix/map.h>
+#include <Matrix/mask.h>
+#include <Matrix/indexing.h>
+#include <Matrix/sorting.h>
+#include <Matrix/packed.h>
+#include <Matrix/structured.h>
+#include <Matrix/exact.h>
+#include <Matrix/incremental.h>
+#include <Matrix/external.h>
+#include <Matrix/random.h>
+#include <Matrix/convolution.h>
+#include <Matrix/task_graph.h>
+#include <Matrix/snapshot.h>
+#include <Matrix/tiled_matrix.h>
+#include <Matrix/distributed.h>
+#include <Matrix/autotune.h>
 
 #endif // MATRIX_H
@@ -4,8 +4,34 @@
 
 #include <vector>
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 #include <boost/test/unit_test.hpp>
 
+//heap allocations of test binary, kernels which take temporaries from arenas must not change it
+static std::atomic<size_t> heap_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    ++heap_allocations;
+    if(void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
 BOOST_AUTO_TEST_SUITE(test_matrix)
 
 BOOST_AUTO_TEST_CASE(check_init_default_matrix)
@@ -262,4 +288,1175 @@ BOOST_AUTO_TEST_CASE(check_arithmetic_operation)
     BOOST_CHECK_EQUAL_COLLECTIONS(m3.begin(), m3.end(), vec3.begin(), vec3.end()); 
 }
 
+BOOST_AUTO_TEST_CASE(check_reductions)
+{
+    matrix_view::Matrix<int> m{{1,2,4,5},
+                               {6,7,9,-2},
+                               {-5,6,-9,3}};
+
+    std::vector<int> sumColumns = {2,15,4,6};
+    std::vector<int> sumRows = {12,20,-5};
+    std::vector<size_t> argmaxColumns = {1,1,1,0};
+    std::vector<int> minRows = {1,-2,-9};
+
+    BOOST_CHECK(matrix_view::sum(m) == 27);
+    BOOST_CHECK(matrix_view::min(m) == -9);
+    BOOST_CHECK(matrix_view::max(m) == 9);
+    BOOST_CHECK(matrix_view::argmin(m) == 10);
+    BOOST_CHECK(matrix_view::argmax(m) == 6);
+    BOOST_CHECK_CLOSE(matrix_view::mean(m), 27.0 / 12, 1e-9);
+
+    auto s0 = matrix_view::sum(m, 0);
+    auto s1 = matrix_view::sum(m, 1);
+    auto a0 = matrix_view::argmax(m, 0);
+    auto min1 = matrix_view::min(m, 1);
+    BOOST_CHECK(s0.rows() == 1 && s0.columns() == 4);
+    BOOST_CHECK(s1.rows() == 3 && s1.columns() == 1);
+    BOOST_CHECK_EQUAL_COLLECTIONS(s0.begin(), s0.end(), sumColumns.begin(), sumColumns.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(s1.begin(), s1.end(), sumRows.begin(), sumRows.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(a0.begin(), a0.end(), argmaxColumns.begin(), argmaxColumns.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(min1.begin(), min1.end(), minRows.begin(), minRows.end());
+
+    BOOST_CHECK(matrix_view::sum(m("0:2,1:3")) == 22);
+    BOOST_CHECK_CLOSE(matrix_view::norm(m, matrix_view::Norm::L1), 59.0, 1e-9);
+    BOOST_CHECK_CLOSE(matrix_view::norm(m, matrix_view::Norm::Inf), 9.0, 1e-9);
+    BOOST_CHECK_CLOSE(matrix_view::norm(m("0,:")), std::sqrt(46.0), 1e-9);
+    BOOST_CHECK_THROW(matrix_view::sum(m, 2), std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(check_reductions_large_float)
+{
+    //float sum of 0.1 must not drift on millions of elements
+    matrix_view::set_threads(4);
+    matrix_view::Matrix<float> m(1000, 3000, 0.1f);
+
+    BOOST_CHECK_CLOSE(matrix_view::sum(m), 300000.0f, 1e-3);
+    auto s0 = matrix_view::sum(m, 0);
+    auto s1 = matrix_view::sum(m, 1);
+    BOOST_CHECK_CLOSE(s0(0, 2999), 100.0f, 1e-3);
+    BOOST_CHECK_CLOSE(s1(999, 0), 300.0f, 1e-3);
+
+    m(500, 1234) = 7;
+    BOOST_CHECK(matrix_view::argmax(m) == 500 * 3000 + 1234);
+    BOOST_CHECK(matrix_view::argmax(m, 0)(0, 1234) == 500);
+    matrix_view::set_threads(0);
+}
+
+BOOST_AUTO_TEST_CASE(check_broadcast_row_and_column)
+{
+    matrix_view::Matrix<int> m{{1,2,4},
+                               {6,7,9}};
+    matrix_view::Matrix<int> row{10,20,30};
+    matrix_view::Matrix<int> column(2, 1);
+    column(0,0) = 2;
+    column(1,0) = 3;
+
+    matrix_view::Matrix<int> plusRow{{11,22,34},
+                                     {16,27,39}};
+    matrix_view::Matrix<int> timesColumn{{2,4,8},
+                                         {18,21,27}};
+    matrix_view::Matrix<int> rowMinus{{9,18,26},
+                                      {4,13,21}};
+    matrix_view::Matrix<int> outer{{12,22,32},
+                                   {13,23,33}};
+
+    auto m1(m);
+    m1 += row;
+    BOOST_CHECK(m1 == plusRow);
+    auto m2(m);
+    m2 *= column;
+    BOOST_CHECK(m2 == timesColumn);
+    BOOST_CHECK((m + row) == plusRow);
+    BOOST_CHECK((row - m) == rowMinus);
+    BOOST_CHECK((column * m) == timesColumn);
+    BOOST_CHECK((row + column) == outer);
+    matrix_view::Matrix<int> wrong{1,2};
+    BOOST_CHECK_THROW(m += wrong, std::runtime_error);
+
+    //operand is a slice of the matrix itself
+    matrix_view::Matrix<int> a{{1,2},{3,4}};
+    a += a("0:1,:");
+    BOOST_CHECK(a == (matrix_view::Matrix<int>{{2,4},{4,6}}));
+    matrix_view::Matrix<int> b{{1,2},{3,4}};
+    b -= b(":,1:2");
+    BOOST_CHECK(b == (matrix_view::Matrix<int>{{-1,0},{-1,0}}));
+}
+
+BOOST_AUTO_TEST_CASE(check_philox_known_answer)
+{
+    auto zero = matrix_view::detail::philox4x32({0, 0, 0, 0}, 0);
+    std::vector<uint32_t> zeroAnswer = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8};
+    BOOST_CHECK_EQUAL_COLLECTIONS(zero.begin(), zero.end(), zeroAnswer.begin(), zeroAnswer.end());
+
+    auto pi = matrix_view::detail::philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                                              0x299f31d0a4093822);
+    std::vector<uint32_t> piAnswer = {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1};
+    BOOST_CHECK_EQUAL_COLLECTIONS(pi.begin(), pi.end(), piAnswer.begin(), piAnswer.end());
+}
+
+BOOST_AUTO_TEST_CASE(check_random_matrix)
+{
+    auto m1 = matrix_view::make_random_matrix<int>(300, 300, -5, 7, 42);
+    matrix_view::set_threads(3);
+    auto m2 = matrix_view::make_random_matrix<int>(300, 300, -5, 7, 42);
+    auto n1 = matrix_view::make_normal_matrix<double>(301, 301, 1.0, 2.0, 7);
+    matrix_view::set_threads(0);
+    auto n2 = matrix_view::make_normal_matrix<double>(301, 301, 1.0, 2.0, 7);
+
+    BOOST_CHECK(m1 == m2);
+    BOOST_CHECK(n1 == n2);
+    BOOST_CHECK(matrix_view::min(m1) == -5);
+    BOOST_CHECK(matrix_view::max(m1) == 6);
+    BOOST_CHECK(matrix_view::make_random_matrix<int>(10, 10, 0, 1000) !=
+                matrix_view::make_random_matrix<int>(10, 10, 0, 1000));
+
+    auto u = matrix_view::make_uniform_matrix<float>(100, 100, 2.0f, 3.0f, 1);
+    BOOST_CHECK(matrix_view::min(u) >= 2.0f && matrix_view::max(u) < 3.0f);
+    BOOST_CHECK_CLOSE(matrix_view::mean(u), 2.5f, 1);
+
+    double mean = matrix_view::mean(n1);
+    double variance = matrix_view::mean((n1 - mean) * (n1 - mean));
+    BOOST_CHECK_CLOSE(mean, 1.0, 5);
+    BOOST_CHECK_CLOSE(variance, 4.0, 5);
+}
+
+BOOST_AUTO_TEST_CASE(check_dot)
+{
+    matrix_view::Matrix<int> m1{{1,2,4},
+                                {6,7,9}};
+    matrix_view::Matrix<int> m2{{3,6},
+                                {4,2},
+                                {2,6}};
+    matrix_view::Matrix<int> res{{19,34},
+                                 {64,104}};
+
+    BOOST_CHECK(m1.dot(m2) == res);
+    BOOST_CHECK(m1.dot(m2, matrix_view::Product::Strassen) == res);
+    BOOST_CHECK_THROW(m1.dot(m1), std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(check_dot_strassen)
+{
+    //odd sizes and small crossover check peeling and several levels of recursion
+    auto params = matrix_view::detail::gemm_params;
+    matrix_view::detail::gemm_params.strassenCrossover = 8;
+    auto a = matrix_view::make_random_matrix<long>(67, 45, -9, 10, 1);
+    auto b = matrix_view::make_random_matrix<long>(45, 83, -9, 10, 2);
+
+    matrix_view::Matrix<long> res(67, 83);
+    for(size_t i = 0; i < 67; ++i)
+        for(size_t j = 0; j < 83; ++j)
+            for(size_t k = 0; k < 45; ++k)
+                res(i, j) += a(i, k) * b(k, j);
+
+    BOOST_CHECK(a.dot(b) == res);
+    BOOST_CHECK(a.dot(b, matrix_view::Product::Strassen) == res);
+    matrix_view::set_threads(4);
+    BOOST_CHECK(a.dot(b) == res);
+    BOOST_CHECK(a.dot(b, matrix_view::Product::Strassen) == res);
+    matrix_view::set_threads(0);
+    matrix_view::detail::gemm_params = params;
+}
+
+BOOST_AUTO_TEST_CASE(check_transpose)
+{
+    //fractional values are not truncated, non-square shape spans several tiles
+    matrix_view::Matrix<double> m{{0.5, 1.25, -2.75},
+                                  {3.5, -0.125, 4.0}};
+    m.transpose();
+    BOOST_CHECK(m == (matrix_view::Matrix<double>{{0.5, 3.5},
+                                                  {1.25, -0.125},
+                                                  {-2.75, 4.0}}));
+
+    auto a = matrix_view::make_random_matrix<double>(70, 45, -1, 1, 3);
+    auto t = a;
+    t.transpose();
+    BOOST_CHECK(t.rows() == 45 && t.columns() == 70);
+    bool same = true;
+    for(size_t i = 0; i < 70; ++i)
+        for(size_t j = 0; j < 45; ++j)
+            same = same && t(j, i) == a(i, j);
+    BOOST_CHECK(same);
+}
+
+BOOST_AUTO_TEST_CASE(check_gemv_and_rank1_update)
+{
+    matrix_view::Matrix<int> a{{1,2,4},
+                               {6,7,9}};
+    matrix_view::Matrix<int> x{1,-1,2};
+    matrix_view::Matrix<int> xt(2, 1, 1);
+    xt(1,0) = 2;
+
+    matrix_view::Matrix<int> y{1,1};
+    matrix_view::gemv(2, a, x, 3, y);
+    std::vector<int> gemvRes = {2 * 7 + 3, 2 * 17 + 3};
+    BOOST_CHECK_EQUAL_COLLECTIONS(y.begin(), y.end(), gemvRes.begin(), gemvRes.end());
+
+    matrix_view::Matrix<int> yt(1, 3);
+    matrix_view::gemv_transposed(1, a, xt, 0, yt);
+    std::vector<int> gemvTRes = {13,16,22};
+    BOOST_CHECK_EQUAL_COLLECTIONS(yt.begin(), yt.end(), gemvTRes.begin(), gemvTRes.end());
+
+    matrix_view::rank1_update(a, 2, xt, x);
+    matrix_view::Matrix<int> rank1Res{{3,0,8},
+                                      {10,3,17}};
+    BOOST_CHECK(a == rank1Res);
+
+    matrix_view::Matrix<int> column(3, 1);
+    std::copy(x.begin(), x.end(), column.begin());
+    auto dotColumn = a.dot(column);
+    std::vector<int> dotColumnRes = {19,41};
+    BOOST_CHECK(dotColumn.rows() == 2 && dotColumn.columns() == 1);
+    BOOST_CHECK_EQUAL_COLLECTIONS(dotColumn.begin(), dotColumn.end(), dotColumnRes.begin(), dotColumnRes.end());
+    BOOST_CHECK(matrix_view::Matrix<int>({1,2}).dot(a) == matrix_view::Matrix<int>({23,6,42}));
+    BOOST_CHECK_THROW(matrix_view::gemv(1, a, y, 0, y), std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(check_matrix_power)
+{
+    matrix_view::Matrix<long> fib{{1,1},
+                                  {1,0}};
+    matrix_view::Matrix<long> fib50{{20365011074,12586269025},
+                                    {12586269025,7778742049}};
+    matrix_view::Matrix<long> identity{{1,0},
+                                       {0,1}};
+
+    BOOST_CHECK(matrix_view::matrix_power(fib, 50) == fib50);
+    BOOST_CHECK(matrix_view::matrix_power(fib, 1) == fib);
+    BOOST_CHECK(matrix_view::matrix_power(fib, 0) == identity);
+
+    auto a = matrix_view::make_random_matrix<long>(9, 9, -2, 3, 5);
+    auto vectors = matrix_view::make_random_matrix<long>(9, 4, -2, 3, 6);
+    auto expected = vectors;
+    for(int i = 0; i < 7; ++i)
+        expected = a.dot(expected);
+    BOOST_CHECK(matrix_view::matrix_power(a, 7).dot(vectors) == expected);
+    BOOST_CHECK(matrix_view::matrix_power(a, 7, vectors) == expected);
+    BOOST_CHECK(matrix_view::matrix_power(a, 2, vectors) == a.dot(a.dot(vectors)));
+    BOOST_CHECK_THROW(matrix_view::matrix_power(vectors, 2), std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(check_conv2d)
+{
+    matrix_view::Matrix<int> image{{1,2,3},
+                                   {4,5,6},
+                                   {7,8,9}};
+    matrix_view::Matrix<int> kernel{{1,0},
+                                    {0,-1}};
+    matrix_view::Matrix<int> full{{1,2,3,0},
+                                  {4,4,4,-3},
+                                  {7,4,4,-6},
+                                  {0,-7,-8,-9}};
+    matrix_view::Matrix<int> same{{1,2,3},
+                                  {4,4,4},
+                                  {7,4,4}};
+    matrix_view::Matrix<int> valid{{4,4},
+                                   {4,4}};
+    matrix_view::Matrix<int> correlateValid{{-4,-4},
+                                            {-4,-4}};
+
+    for(auto method: {matrix_view::ConvMethod::Direct, matrix_view::ConvMethod::Im2col,
+                      matrix_view::ConvMethod::FFT}){
+        BOOST_CHECK(matrix_view::conv2d(image, kernel, matrix_view::ConvMode::Full, method) == full);
+        BOOST_CHECK(matrix_view::conv2d(image, kernel, matrix_view::ConvMode::Same, method) == same);
+        BOOST_CHECK(matrix_view::conv2d(image, kernel, matrix_view::ConvMode::Valid, method) == valid);
+        BOOST_CHECK(matrix_view::correlate2d(image, kernel, matrix_view::ConvMode::Valid, method) == correlateValid);
+    }
+    BOOST_CHECK_THROW(matrix_view::conv2d(kernel, image, matrix_view::ConvMode::Valid), std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(check_conv2d_methods_agree)
+{
+    auto image = matrix_view::make_uniform_matrix<double>(70, 53, -1, 1, 3);
+    auto kernel = matrix_view::make_uniform_matrix<double>(9, 6, -1, 1, 4);
+    matrix_view::set_threads(3);
+    for(auto mode: {matrix_view::ConvMode::Full, matrix_view::ConvMode::Same, matrix_view::ConvMode::Valid}){
+        auto direct = matrix_view::correlate2d(image, kernel, mode, matrix_view::ConvMethod::Direct);
+        auto im2col = matrix_view::correlate2d(image, kernel, mode, matrix_view::ConvMethod::Im2col);
+        auto fft = matrix_view::correlate2d(image, kernel, mode, matrix_view::ConvMethod::FFT);
+        BOOST_CHECK(direct.rows() == fft.rows() && direct.columns() == fft.columns());
+        BOOST_CHECK_SMALL(matrix_view::norm(direct - im2col, matrix_view::Norm::Inf), 1e-9);
+        BOOST_CHECK_SMALL(matrix_view::norm(direct - fft, matrix_view::Norm::Inf), 1e-9);
+    }
+    matrix_view::set_threads(0);
+}
+
+BOOST_AUTO_TEST_CASE(check_task_graph)
+{
+    auto a = matrix_view::make_random_matrix<long>(40, 30, -5, 5, 1);
+    auto b = matrix_view::make_random_matrix<long>(30, 20, -5, 5, 2);
+    auto c = matrix_view::make_random_matrix<long>(40, 20, -5, 5, 3);
+
+    matrix_view::TaskGraph graph(4);
+    auto la = graph.value(a);
+    auto lb = graph.value(b);
+    auto lc = graph.value(c);
+    auto ab = graph.dot(la, lb);
+    auto sum = graph.add([](const matrix_view::Matrix<long>& x, const matrix_view::Matrix<long>& y){
+        return x + y;
+    }, ab, lc);
+    auto joined = graph.cat(2, graph.dot(la, lb), sum);
+    auto total = graph.add([](const matrix_view::Matrix<long>& m){ return matrix_view::sum(m); }, joined);
+
+    BOOST_CHECK(!sum.ready());
+    graph.run();
+
+    auto expected = matrix_view::cat(2, a.dot(b), a.dot(b) + c);
+    BOOST_CHECK(a.dot(b) == ab.get());
+    BOOST_CHECK(expected == joined.get());
+    BOOST_CHECK(total.get() == matrix_view::sum(expected));
+
+    //tasks may be added to graph after run
+    auto twice = graph.add([](const matrix_view::Matrix<long>& m){ return m * 2; }, sum);
+    graph.run();
+    BOOST_CHECK((a.dot(b) + c) * 2 == twice.get());
+}
+
+BOOST_AUTO_TEST_CASE(check_task_graph_exception)
+{
+    matrix_view::TaskGraph graph(2);
+    auto a = graph.value(matrix_view::Matrix<int>(2, 3, 1));
+    auto wrong = graph.dot(a, a);
+    auto dependent = graph.add([](const matrix_view::Matrix<int>& m){ return m + 1; }, wrong);
+    auto independent = graph.add([](const matrix_view::Matrix<int>& m){ return m + 1; }, a);
+
+    BOOST_CHECK_THROW(graph.run(), std::length_error);
+    BOOST_CHECK_THROW(dependent.get(), std::length_error);
+    BOOST_CHECK(matrix_view::Matrix<int>(2, 3, 2) == independent.get());
+}
+
+BOOST_AUTO_TEST_CASE(check_tiled_matrix)
+{
+    auto dir = std::filesystem::temp_directory_path();
+    auto a = matrix_view::make_random_matrix<long>(10, 7, -9, 10, 1);
+    auto b = matrix_view::make_random_matrix<long>(7, 9, -9, 10, 2);
+    {
+        //tiles 4x4 with 2 tiles in cache, so tiles are evicted and edge tiles are padded
+        auto ta = matrix_view::TiledMatrix<long>::from_matrix((dir / "tiled_a").string(), a, 4, 2);
+        auto tb = matrix_view::TiledMatrix<long>::from_matrix((dir / "tiled_b").string(), b, 4, 2);
+        BOOST_CHECK(ta.tile_rows() == 3 && ta.tile_columns() == 2);
+        BOOST_CHECK(ta.get(9, 6) == a(9, 6));
+        BOOST_CHECK(a == ta.to_matrix());
+
+        ta.set(9, 6, 100);
+        a(9, 6) = 100;
+        ta.set(0, 0, -100);
+        a(0, 0) = -100;
+
+        auto product = matrix_view::dot(ta, tb, (dir / "tiled_ab").string(), 2);
+        BOOST_CHECK(a.dot(b) == product.to_matrix());
+
+        auto transposed = matrix_view::transpose(ta, (dir / "tiled_at").string());
+        auto at = a;
+        at.transpose();
+        BOOST_CHECK(at == transposed.to_matrix());
+
+        auto plusOne = matrix_view::transform(ta, (dir / "tiled_a1").string(), [](long x){ return x + 1; });
+        auto twice = matrix_view::transform(ta, plusOne, (dir / "tiled_a2").string(),
+                                            [](long x, long y){ return x + y; });
+        BOOST_CHECK(a * 2 + 1 == twice.to_matrix());
+        //padding stays 0 after transform
+        BOOST_CHECK(matrix_view::sum(plusOne.read_tile(2, 1)) == matrix_view::sum(a("8:10,4:7")) + 6);
+
+        //raw write clears padding in its own copy, buffer of caller is kept
+        std::vector<long> raw(16, 5);
+        plusOne.write_raw(2, 1, raw.data());
+        BOOST_CHECK(std::count(raw.begin(), raw.end(), 5) == 16);
+        std::vector<long> written(16);
+        plusOne.read_raw(2, 1, written.data());
+        BOOST_CHECK(std::count(written.begin(), written.end(), 5) == 6);
+    }
+    auto reopened = matrix_view::TiledMatrix<long>::open((dir / "tiled_a").string());
+    BOOST_CHECK(a == reopened.to_matrix());
+    for(auto name: {"tiled_a", "tiled_b", "tiled_ab", "tiled_at", "tiled_a1", "tiled_a2"})
+        std::filesystem::remove(dir / name);
+}
+
+BOOST_AUTO_TEST_CASE(check_sharded_matrix)
+{
+    auto dir = std::filesystem::temp_directory_path() / ("sharded_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(dir);
+    auto a = matrix_view::make_random_matrix<long>(23, 17, -10, 10, 1);
+    auto b = matrix_view::make_random_matrix<long>(17, 13, -10, 10, 2);
+    auto ab = a.dot(b);
+
+    bool gathered = false, product = false;
+    matrix_view::run_local_cluster(4, dir.string(), [&](matrix_view::Transport &transport){
+        auto sa = matrix_view::ShardedMatrix<long>::scatter(transport, a, 23, 17, 4);
+        auto sb = matrix_view::ShardedMatrix<long>::scatter(transport, b, 17, 13, 4);
+        if(sa.grid_rows() != 2 || sa.grid_columns() != 2)
+            throw std::runtime_error("wrong grid");
+        auto sc = matrix_view::dot(sa, sb);
+        auto fullA = sa.gather();
+        auto fullC = sc.gather();
+        if(transport.rank() == 0){
+            gathered = a == fullA;
+            product = ab == fullC;
+        }
+    });
+    BOOST_CHECK(gathered);
+    BOOST_CHECK(product);
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(check_numa_placement)
+{
+    //node of pages and pinning of threads are not observable on machine with one node,
+    //so only values and amount of reported pages are checked
+    matrix_view::set_threads(4);
+    for(auto placement: {matrix_view::NumaPlacement::Local, matrix_view::NumaPlacement::Interleave,
+                         matrix_view::NumaPlacement::RowBlocks}){
+        matrix_view::set_numa_placement(placement);
+        matrix_view::Matrix<double> m(300, 200, 1.5);
+        BOOST_CHECK(matrix_view::sum(m) == 1.5 * 300 * 200);
+
+        auto report = matrix_view::numa_report(m);
+        BOOST_CHECK(report.pages.size() == matrix_view::numa_nodes());
+        size_t pages = report.unknown;
+        for(auto n: report.pages)
+            pages += n;
+        size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+        size_t first = reinterpret_cast<uintptr_t>(m.data()) / pageSize;
+        size_t last = (reinterpret_cast<uintptr_t>(m.data()) + sizeof(double) * 300 * 200 - 1) / pageSize;
+        BOOST_CHECK(pages == last - first + 1);
+    }
+    matrix_view::set_threads(0);
+}
+
+BOOST_AUTO_TEST_CASE(check_map)
+{
+    matrix_view::set_threads(3);
+    auto a = matrix_view::make_uniform_matrix<double>(300, 250, -1.0, 1.0, 5);
+    auto b = matrix_view::make_uniform_matrix<double>(300, 250, 0.5, 2.0, 6);
+    auto c = matrix_view::make_uniform_matrix<double>(300, 250, 0.0, 1.0, 7);
+
+    auto fused = matrix_view::map([](double x, double y, double z){ return x * y + z; }, a, b, c);
+    BOOST_CHECK(fused.rows() == 300 && fused.columns() == 250);
+    BOOST_CHECK(fused(123, 45) == a(123, 45) * b(123, 45) + c(123, 45));
+
+    auto zipped = matrix_view::zip_with([](double x, double y){ return x - y; }, a, b);
+    BOOST_CHECK(zipped == a - b);
+
+    //in place
+    auto d = a;
+    matrix_view::map_to(d, [](double x, double y){ return x + y; }, d, b);
+    BOOST_CHECK(d == a + b);
+
+    double dotProduct = matrix_view::map_reduce([](double x, double y){ return x * y; }, std::plus<>(), 0.0, a, b);
+    double expected = 0;
+    for(size_t i = 0; i < a.rows(); ++i)
+        for(size_t j = 0; j < a.columns(); ++j)
+            expected += a(i, j) * b(i, j);
+    BOOST_CHECK_CLOSE(dotProduct, expected, 1e-9);
+    long count = matrix_view::map_reduce([](double x){ return long(x > 0); }, std::plus<>(), 0l, a);
+    BOOST_CHECK(count > 0 && count < 300 * 250);
+
+    BOOST_CHECK_THROW(matrix_view::map(std::plus<>(), a, matrix_view::Matrix<double>(2, 2)), std::runtime_error);
+
+    //slices are mapped and written through
+    matrix_view::Matrix<int> m{{1, 2, 3}, {4, 5, 6}};
+    auto slice = m(":,1:3");
+    auto squares = matrix_view::map([](int x){ return x * x; }, slice);
+    matrix_view::Matrix<int> squaresExpected{{4, 9}, {25, 36}};
+    BOOST_CHECK(squares == squaresExpected);
+    matrix_view::map_to(slice, [](int x){ return -x; }, slice);
+    matrix_view::Matrix<int> negated{{1, -2, -3}, {4, -5, -6}};
+    BOOST_CHECK(m == negated);
+    matrix_view::set_threads(0);
+}
+
+BOOST_AUTO_TEST_CASE(check_atan2_and_pow)
+{
+    matrix_view::Matrix<double> y{{1, -1}, {0, 2}};
+    matrix_view::Matrix<double> x{{1, 1}, {-1, 0}};
+    auto angle = matrix_view::atan2(y, x);
+    BOOST_CHECK(angle(0, 0) == std::atan2(1.0, 1.0));
+    BOOST_CHECK(angle(1, 0) == std::atan2(0.0, -1.0));
+    BOOST_CHECK_THROW(matrix_view::atan2(y, matrix_view::Matrix<double>(1, 2)), std::runtime_error);
+
+    matrix_view::Matrix<int> m{{1, 2}, {-3, 4}};
+    matrix_view::Matrix<int> cube{{1, 8}, {-27, 64}};
+    BOOST_CHECK(matrix_view::pow<3>(m) == cube);
+    BOOST_CHECK(matrix_view::pow(m, 3) == cube);
+    auto half = matrix_view::pow(y, 0.5);
+    BOOST_CHECK(half(1, 1) == std::sqrt(2.0));
+    matrix_view::Matrix<double> inverse{{1.0, 0.5}, {0.25, 2.0}};
+    matrix_view::Matrix<double> inverseExpected{{1.0, 2.0}, {4.0, 0.5}};
+    BOOST_CHECK(matrix_view::pow<-1>(inverse) == inverseExpected);
+}
+
+BOOST_AUTO_TEST_CASE(check_masks)
+{
+    matrix_view::Matrix<int> m{{1, 7, 3}, {9, 5, 6}};
+    auto big = m > 5;
+    BOOST_CHECK(big.rows() == 2 && big.columns() == 3);
+    BOOST_CHECK(!big(0, 0) && big(0, 1) && !big(0, 2) && big(1, 0) && !big(1, 1) && big(1, 2));
+    BOOST_CHECK(matrix_view::count(big) == 3);
+    BOOST_CHECK(matrix_view::any(big) && !matrix_view::all(big));
+    BOOST_CHECK(matrix_view::all(m >= 1) && !matrix_view::any(m < 1));
+    BOOST_CHECK((2 < m) == (m > 2));
+    BOOST_CHECK(matrix_view::count(~big) == 3);
+    BOOST_CHECK(matrix_view::count(big & (m < 8)) == 2);
+    BOOST_CHECK(matrix_view::count(big | (m < 2)) == 4);
+    BOOST_CHECK(matrix_view::count(matrix_view::equal_to(m, m)) == 6);
+    BOOST_CHECK(!matrix_view::any(matrix_view::not_equal_to(m, m)));
+
+    auto values = m[big].values();
+    matrix_view::Matrix<int> valuesExpected{7, 9, 6};
+    BOOST_CHECK(values == valuesExpected);
+
+    matrix_view::Matrix<int> selected{{0, 7, 0}, {9, 0, 6}};
+    BOOST_CHECK(matrix_view::where(big, m, 0) == selected);
+    BOOST_CHECK(matrix_view::where(big, m, m * 10) == selected + matrix_view::where(~big, m * 10, 0));
+
+    m[m > 5] = 0;
+    matrix_view::Matrix<int> zeroed{{1, 0, 3}, {0, 5, 0}};
+    BOOST_CHECK(m == zeroed);
+    m[matrix_view::equal_to(m, 0)] = matrix_view::Matrix<int>{{10, 20, 30}, {40, 50, 60}};
+    matrix_view::Matrix<int> filled{{1, 20, 3}, {40, 5, 60}};
+    BOOST_CHECK(m == filled);
+    BOOST_CHECK_THROW(m > matrix_view::Matrix<int>(3, 2), std::runtime_error);
+
+    //masks longer than one word
+    auto large = matrix_view::make_random_matrix<int>(77, 31, 0, 100, 3);
+    auto half = large < 50;
+    size_t expected = 0;
+    for(auto x: large)
+        expected += x < 50;
+    BOOST_CHECK(matrix_view::count(half) == expected);
+    BOOST_CHECK(matrix_view::count(~half) == large.rows() * large.columns() - expected);
+    BOOST_CHECK(matrix_view::all(half | ~half));
+}
+
+BOOST_AUTO_TEST_CASE(check_allclose)
+{
+    matrix_view::Matrix<double> a{{1.0, 2.0}, {3.0, 4.0}};
+    auto b = a + 1e-10;
+    BOOST_CHECK(!(a == b));
+    BOOST_CHECK(matrix_view::allclose(a, b));
+    b(1, 1) = 4.1;
+    BOOST_CHECK(!matrix_view::allclose(a, b));
+    BOOST_CHECK(matrix_view::count(matrix_view::isclose(a, b)) == 3);
+    BOOST_CHECK(matrix_view::allclose(a, b, 0.05));
+    BOOST_CHECK(!matrix_view::allclose(a, matrix_view::Matrix<double>(2, 3)));
+
+    //operator== is const
+    const matrix_view::Matrix<double> c = a;
+    BOOST_CHECK(c == a);
+    BOOST_CHECK(!(c != a));
+}
+
+BOOST_AUTO_TEST_CASE(check_take_and_put_rows)
+{
+    matrix_view::Matrix<int> m{{1, 2, 3}, {4, 5, 6}, {7, 8, 9}, {10, 11, 12}};
+    matrix_view::Matrix<int> rows{{7, 8, 9}, {1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+    BOOST_CHECK(matrix_view::take_rows(m, {2, 0, 1, 2}) == rows);
+    matrix_view::Matrix<int> columns{{3, 1, 2}, {6, 4, 5}, {9, 7, 8}, {12, 10, 11}};
+    BOOST_CHECK(matrix_view::take_cols(m, {2, 0, 1}) == columns);
+    BOOST_CHECK(matrix_view::take_rows(m, {}).rows() == 0);
+    BOOST_CHECK_THROW(matrix_view::take_rows(m, {4}), std::out_of_range);
+    BOOST_CHECK_THROW(matrix_view::take_cols(m, {3}), std::out_of_range);
+
+    //slices
+    auto slice = m("1:3,1:3");
+    matrix_view::Matrix<int> sliceRows{{8, 9}, {5, 6}};
+    BOOST_CHECK(matrix_view::take_rows(slice, {1, 0}) == sliceRows);
+
+    matrix_view::put_rows(m, {3, 0}, matrix_view::Matrix<int>{{0, 0, 0}, {-1, -2, -3}});
+    matrix_view::Matrix<int> put{{-1, -2, -3}, {4, 5, 6}, {7, 8, 9}, {0, 0, 0}};
+    BOOST_CHECK(m == put);
+    matrix_view::put_rows(m, {1, 1}, matrix_view::Matrix<int>{{0, 0, 0}, {1, 1, 1}});
+    BOOST_CHECK(m(1, 0) == 1 && m(1, 2) == 1);
+    BOOST_CHECK_THROW(matrix_view::put_rows(m, {1}, matrix_view::Matrix<int>(2, 3)), std::runtime_error);
+
+    //large gather runs in parallel, runs of consecutive rows are copied at once
+    matrix_view::set_threads(3);
+    auto large = matrix_view::make_random_matrix<long>(5000, 40, -100, 100, 9);
+    std::vector<size_t> indices;
+    for(size_t i = 0; i < 3000; ++i)
+        indices.push_back(i % 7 == 0 ? (i * 7919) % 5000 : i);
+    auto taken = matrix_view::take_rows(large, indices);
+    bool same = true;
+    for(size_t k = 0; k < indices.size(); ++k)
+        for(size_t j = 0; j < large.columns(); ++j)
+            same = same && taken(k, j) == large(indices[k], j);
+    BOOST_CHECK(same);
+    auto copy = large;
+    matrix_view::put_rows(copy, indices, taken);
+    BOOST_CHECK(copy == large);
+    matrix_view::set_threads(0);
+}
+
+BOOST_AUTO_TEST_CASE(check_sort_rows)
+{
+    matrix_view::Matrix<int> m{{3, 1, 2, 1}, {-5, 7, 0, 7}};
+    matrix_view::Matrix<int> sorted{{1, 1, 2, 3}, {-5, 0, 7, 7}};
+    BOOST_CHECK(matrix_view::sort_rows(m) == sorted);
+    matrix_view::Matrix<size_t> order{{1, 3, 2, 0}, {0, 2, 1, 3}};
+    BOOST_CHECK(matrix_view::argsort_rows(m) == order);
+    matrix_view::Matrix<size_t> descending{{0, 2, 1, 3}, {1, 3, 2, 0}};
+    BOOST_CHECK(matrix_view::argsort_rows(m, matrix_view::Order::Descending) == descending);
+
+    auto top = matrix_view::topk_rows(m, 2);
+    matrix_view::Matrix<int> topValues{{3, 2}, {7, 7}};
+    matrix_view::Matrix<size_t> topIndices{{0, 2}, {1, 3}};
+    BOOST_CHECK(top.values == topValues);
+    BOOST_CHECK(top.indices == topIndices);
+    BOOST_CHECK_THROW(matrix_view::topk_rows(m, 5), std::logic_error);
+
+    matrix_view::Matrix<int> columns{{-5, 1, 0, 1}, {3, 7, 2, 7}};
+    BOOST_CHECK(matrix_view::sort_cols(m) == columns);
+    auto topColumn = matrix_view::topk_cols(m, 1, matrix_view::Order::Ascending);
+    matrix_view::Matrix<int> smallest{-5, 1, 0, 1};
+    matrix_view::Matrix<size_t> smallestIndices{1, 0, 1, 0};
+    BOOST_CHECK(topColumn.values == smallest);
+    BOOST_CHECK(topColumn.indices == smallestIndices);
+}
+
+BOOST_AUTO_TEST_CASE(check_sort_rows_methods_agree)
+{
+    matrix_view::set_threads(3);
+    //short rows use sorting network, long rows use sort, heap or nth_element
+    for(size_t columns: {1, 5, 16, 17, 200}){
+        auto m = matrix_view::make_uniform_matrix<double>(301, columns, -1.0, 1.0, columns);
+        m(7, 0) = std::numeric_limits<double>::infinity();
+        auto sorted = matrix_view::sort_rows(m);
+        auto indices = matrix_view::argsort_rows(m, matrix_view::Order::Descending);
+        bool ok = true;
+        for(size_t i = 0; i < m.rows(); ++i){
+            std::vector<double> row(m.begin_row(i), m.end_row(i));
+            std::sort(row.begin(), row.end());
+            for(size_t j = 0; j < columns; ++j){
+                ok = ok && sorted(i, j) == row[j];
+                ok = ok && m(i, indices(i, j)) == row[columns - 1 - j];
+            }
+        }
+        BOOST_CHECK(ok);
+        for(size_t k: {size_t(1), columns / 2, columns}){
+            auto top = matrix_view::topk_rows(m, k);
+            bool same = top.values.columns() == k;
+            for(size_t i = 0; i < m.rows() && k; ++i)
+                for(size_t j = 0; j < k; ++j)
+                    same = same && top.values(i, j) == sorted(i, columns - 1 - j) &&
+                           m(i, top.indices(i, j)) == top.values(i, j);
+            BOOST_CHECK(same);
+        }
+    }
+    matrix_view::set_threads(0);
+}
+
+BOOST_AUTO_TEST_CASE(check_packed_matrices)
+{
+    matrix_view::Matrix<double> full{{4, 1, 2}, {1, 5, 3}, {2, 3, 6}};
+    auto symmetric = matrix_view::SymmetricMatrix<double>::from_matrix(full);
+    BOOST_CHECK(symmetric.packed().size() == 6);
+    BOOST_CHECK(symmetric(0, 2) == 2 && symmetric(2, 0) == 2);
+    BOOST_CHECK(symmetric.to_matrix() == full);
+    auto x = matrix_view::make_uniform_matrix<double>(3, 4, -1.0, 1.0, 1);
+    BOOST_CHECK(matrix_view::allclose(symmetric.dot(x), full.dot(x)));
+    symmetric.set(2, 1, 10);
+    BOOST_CHECK(symmetric(1, 2) == 10);
+    auto twice = symmetric + symmetric * 1.0;
+    BOOST_CHECK(twice.to_matrix() == (symmetric * 2).to_matrix());
+    BOOST_CHECK_THROW(matrix_view::SymmetricMatrix<double>::from_matrix(matrix_view::Matrix<double>(2, 3)), std::length_error);
+
+    for(auto triangle: {matrix_view::Triangle::Lower, matrix_view::Triangle::Upper}){
+        auto t = matrix_view::TriangularMatrix<double>::from_matrix(full, triangle);
+        auto dense = t.to_matrix();
+        bool zeros = true;
+        for(size_t i = 0; i < 3; ++i)
+            for(size_t j = 0; j < 3; ++j){
+                bool stored = triangle == matrix_view::Triangle::Lower ? j <= i : j >= i;
+                zeros = zeros && dense(i, j) == (stored ? full(i, j) : 0.0) && t(i, j) == dense(i, j);
+            }
+        BOOST_CHECK(zeros);
+        BOOST_CHECK(matrix_view::allclose(t.dot(x), dense.dot(x)));
+        auto solution = t.solve(x);
+        BOOST_CHECK(matrix_view::allclose(dense.dot(solution), x));
+        BOOST_CHECK_THROW(t.set(triangle == matrix_view::Triangle::Lower ? 0 : 2, 1, 1.0), std::out_of_range);
+        BOOST_CHECK((t * t).to_matrix() == dense * dense);
+    }
+    matrix_view::TriangularMatrix<double> singular(3);
+    BOOST_CHECK_THROW(singular.solve(x), std::runtime_error);
+
+    auto big = matrix_view::make_random_matrix<long>(40, 30, -5, 5, 4);
+    auto band = matrix_view::BandedMatrix<long>::from_matrix(big, 2, 3);
+    BOOST_CHECK(band.packed().size() == 40 * 6);
+    BOOST_CHECK(band(10, 8) == big(10, 8) && band(10, 13) == big(10, 13));
+    BOOST_CHECK(band(10, 7) == 0 && band(10, 14) == 0);
+    auto bandDense = band.to_matrix();
+    auto y = matrix_view::make_random_matrix<long>(30, 7, -5, 5, 5);
+    BOOST_CHECK(band.dot(y) == bandDense.dot(y));
+    BOOST_CHECK((band - band * 3).to_matrix() == bandDense * -2);
+    BOOST_CHECK_THROW(band + matrix_view::BandedMatrix<long>(40, 30, 1, 3), std::runtime_error);
+    BOOST_CHECK_THROW(band.set(0, 5, 1), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(check_lazy_matrices)
+{
+    auto m = matrix_view::make_random_matrix<long>(4, 3, -9, 9, 11);
+    matrix_view::Identity<long> i3(3), i4(4);
+    matrix_view::Diagonal<long> d3(std::vector<long>{2, -1, 3});
+    matrix_view::Constant<long> c(3, 2, 5);
+
+    BOOST_CHECK(m.dot(i3) == m);
+    BOOST_CHECK(i4.dot(m) == m);
+    BOOST_CHECK(m.dot(d3) == m.dot(d3.to_matrix()));
+    matrix_view::Matrix<long> d4 = matrix_view::Diagonal<long>(std::vector<long>{1, 2, 3, 4});
+    BOOST_CHECK(matrix_view::Diagonal<long>(std::vector<long>{1, 2, 3, 4}).dot(m) == d4.dot(m));
+    BOOST_CHECK(m.dot(c) == m.dot(c.to_matrix()));
+    BOOST_CHECK(matrix_view::Constant<long>(2, 4, -3).dot(m) == matrix_view::Matrix<long>(2, 4, -3).dot(m));
+    BOOST_CHECK_THROW(m.dot(i4), std::length_error);
+
+    //other matrices still go to dense product through conversion
+    matrix_view::Matrix<double> real{{0.5, 1}, {2, -1.5}};
+    matrix_view::Matrix<int> integer{{1, 2}, {3, 4}};
+    BOOST_CHECK(real.dot(integer) == (matrix_view::Matrix<double>{{3.5, 5}, {-2.5, -2}}));
+    BOOST_CHECK(m.dot(m("0:3,0:2")) == m.dot(matrix_view::Matrix<long>(m("0:3,0:2"))));
+
+    auto square = matrix_view::make_random_matrix<long>(3, 3, -9, 9, 12);
+    BOOST_CHECK(square + i3 == square + i3.to_matrix());
+    BOOST_CHECK(d3 - square == d3.to_matrix() - square);
+    BOOST_CHECK(square + matrix_view::Constant<long>(3, 3, 2) == square + 2);
+    BOOST_CHECK((square * d3).to_matrix() == square * d3.to_matrix());
+    BOOST_CHECK((d3 * d3).values() == std::vector<long>({4, 1, 9}));
+    BOOST_CHECK((i3 * 7).to_matrix() == i3.to_matrix() * 7);
+    BOOST_CHECK((2 * c).value() == 10);
+    BOOST_CHECK(d3(1, 1) == -1 && d3(0, 1) == 0 && i3(2, 2) == 1);
+    BOOST_CHECK_THROW(square + i4, std::runtime_error);
+
+    //written copy is dense
+    matrix_view::Matrix<long> dense = c;
+    dense(0, 0) = 1;
+    BOOST_CHECK(dense(0, 0) == 1 && c(0, 0) == 5);
+}
+
+BOOST_AUTO_TEST_CASE(check_exact_det_and_rank)
+{
+    for(size_t n = 1; n <= 6; ++n){
+        auto m = matrix_view::make_random_matrix<long>(n, n, -9, 9, 20 + n);
+        matrix_view::Matrix<double> d(n, n);
+        for(size_t i = 0; i < n; ++i)
+            for(size_t j = 0; j < n; ++j)
+                d(i, j) = double(m(i, j));
+        long expected = std::lround(d.det());
+        BOOST_CHECK(m.det() == expected);
+        BOOST_CHECK(m.det(matrix_view::ExactMethod::Modular) == expected);
+    }
+
+    //l * u with known determinant, its minors overflow 128 bits
+    size_t n = 24;
+    auto l = matrix_view::make_random_matrix<long>(n, n, -1000, 1000, 30);
+    auto u = matrix_view::make_random_matrix<long>(n, n, -1000, 1000, 31);
+    long expected = 1;
+    for(size_t i = 0; i < n; ++i)
+        for(size_t j = 0; j < n; ++j){
+            if(j > i)
+                l(i, j) = 0;
+            if(j < i)
+                u(i, j) = 0;
+            if(i == j){
+                l(i, i) = i % 5 ? 1 : -2;
+                u(i, i) = i % 7 ? -1 : 3;
+                expected *= l(i, i) * u(i, i);
+            }
+        }
+    //reversed rows: 24 * 23 / 2 swaps keep sign of determinant
+    std::vector<size_t> reversed(n);
+    for(size_t i = 0; i < n; ++i)
+        reversed[i] = n - 1 - i;
+    auto a = matrix_view::take_rows(l.dot(u), reversed);
+    BOOST_CHECK_THROW(a.det(matrix_view::ExactMethod::Bareiss), std::overflow_error);
+    BOOST_CHECK(a.det() == expected);
+    BOOST_CHECK(a.det(matrix_view::ExactMethod::Modular) == expected);
+    BOOST_CHECK(a.rank() == n);
+
+    //rank deficient: last rows are combinations of the first ones
+    auto r = matrix_view::make_random_matrix<long>(8, 5, -9, 9, 32);
+    for(size_t j = 0; j < 5; ++j){
+        r(5, j) = r(0, j) - 2 * r(1, j);
+        r(6, j) = 3 * r(2, j);
+        r(7, j) = r(5, j) + r(6, j);
+    }
+    BOOST_CHECK(r.rank() == 5);
+    for(size_t j = 0; j < 5; ++j)
+        r(3, j) = r(4, j) + r(0, j);
+    BOOST_CHECK(r.rank() == 4);
+    BOOST_CHECK(r.rank(matrix_view::ExactMethod::Modular) == 4);
+    matrix_view::Matrix<double> rd(8, 5);
+    for(size_t i = 0; i < 8; ++i)
+        for(size_t j = 0; j < 5; ++j)
+            rd(i, j) = double(r(i, j)) / 7;
+    BOOST_CHECK(rd.rank() == 4);
+
+    matrix_view::Matrix<int> huge{{100000, 1}, {-1, 100000}};
+    BOOST_CHECK_THROW(huge.det(), std::overflow_error);
+    BOOST_CHECK_THROW(matrix_view::Matrix<long>(2, 3).det(), std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(check_snapshot_matrix)
+{
+    matrix_view::SnapshotMatrix<double> model(matrix_view::Matrix<double>(64, 64, 1.0));
+    auto first = model.read();
+    BOOST_CHECK(first.version() == 1 && (*first)(3, 3) == 1.0);
+
+    //every version has all elements equal to its number
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> inconsistent{0}, reads{0};
+    std::vector<std::thread> readers;
+    for(int r = 0; r < 4; ++r){
+        readers.emplace_back([&]{
+            while(!stop.load()){
+                auto snapshot = model.read();
+                double value = snapshot->data()[0];
+                for(size_t k = 0; k < snapshot->rows() * snapshot->columns(); ++k)
+                    if(snapshot->data()[k] != value)
+                        ++inconsistent;
+                ++reads;
+            }
+        });
+    }
+    for(size_t v = 2; v <= 500 || reads.load() < 100; ++v)
+        model.update([v](matrix_view::Matrix<double>& m){
+            for(size_t k = 0; k < m.rows() * m.columns(); ++k)
+                m.data()[k] = double(v);
+        });
+    stop = true;
+    for(auto &t: readers)
+        t.join();
+    BOOST_CHECK(inconsistent.load() == 0);
+
+    //old snapshot is unchanged, retired buffers are reused
+    BOOST_CHECK((*first)(0, 0) == 1.0 && first.version() == 1);
+    size_t buffers = model.buffers();
+    BOOST_CHECK(buffers <= 7);
+    for(int k = 0; k < 100; ++k)
+        model.publish(matrix_view::Matrix<double>(64, 64, double(k)));
+    BOOST_CHECK(model.buffers() == buffers);
+    auto last = model.read();
+    BOOST_CHECK((*last)(63, 63) == 99.0 && last.version() == model.version());
+}
+
+BOOST_AUTO_TEST_CASE(check_incremental_inverse)
+{
+    size_t n = 20;
+    auto a = matrix_view::make_random_matrix<double>(n, n, -5, 5, 40);
+    for(size_t i = 0; i < n; ++i)
+        a(i, i) += 50;
+    matrix_view::IncrementalInverse<double> tracker(a, 0);
+    auto identity = matrix_view::Identity<double>(n).to_matrix();
+    BOOST_CHECK(matrix_view::allclose(a.dot(tracker.inverse()), identity, 1e-9, 1e-9));
+
+    //rank 1 updates with vectors, rank 3 update with n x 3 factors
+    for(uint64_t seed = 0; seed < 10; ++seed){
+        auto u = matrix_view::make_random_matrix<double>(n, 1, -3, 3, 100 + seed);
+        auto v = matrix_view::make_random_matrix<double>(1, n, -3, 3, 200 + seed);
+        tracker.update(u, v);
+        a = a + u.dot(v);
+    }
+    auto u = matrix_view::make_random_matrix<double>(n, 3, -3, 3, 300);
+    auto v = matrix_view::make_random_matrix<double>(n, 3, -3, 3, 301);
+    tracker.update(u, v);
+    auto vt = v;
+    vt.transpose();
+    a = a + u.dot(vt);
+
+    BOOST_CHECK(matrix_view::allclose(tracker.matrix(), a, 1e-12, 1e-9));
+    BOOST_CHECK(matrix_view::allclose(a.dot(tracker.inverse()), identity, 1e-8, 1e-8));
+    matrix_view::IncrementalInverse<double> fresh(a);
+    BOOST_CHECK(std::fabs(tracker.log_det() - fresh.log_det()) < 1e-8);
+    BOOST_CHECK(tracker.sign() == fresh.sign());
+    BOOST_CHECK(tracker.updates() == 11);
+
+    //determinant of small matrix agrees with det()
+    matrix_view::Matrix<double> small{{2, 1, 0}, {1, 3, 1}, {0, 1, 4}};
+    matrix_view::IncrementalInverse<double> s(small, 2);
+    matrix_view::Matrix<double> e(3, 1, 0.0), f(3, 1, 0.0);
+    e(0, 0) = -4;
+    f(0, 0) = 1;
+    s.update(e, f);
+    small(0, 0) -= 4;
+    BOOST_CHECK(std::fabs(s.det() - small.det()) < 1e-9);
+    BOOST_CHECK(s.sign() == -1);
+    s.update(e * 0, f);
+    BOOST_CHECK(s.updates() == 0);
+    BOOST_CHECK(std::fabs(s.det() - small.det()) < 1e-9);
+
+    //update, which makes matrix singular
+    matrix_view::Matrix<double> g(3, 1, 0.0);
+    g(0, 0) = -2;
+    matrix_view::Matrix<double> h(3, 1, 0.0);
+    h(0, 0) = 1;
+    matrix_view::IncrementalInverse<double> diagonal(matrix_view::Diagonal<double>(std::vector<double>{2, 3, 4}));
+    BOOST_CHECK_THROW(diagonal.update(g, h), std::runtime_error);
+    BOOST_CHECK_THROW(matrix_view::IncrementalInverse<double>(matrix_view::Matrix<double>(2, 3)), std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(check_scratch_arena)
+{
+    matrix_view::ScratchArena arena(64);
+    {
+        auto mark = arena.mark();
+        double *p = arena.allocate<double>(100);
+        BOOST_CHECK(reinterpret_cast<uintptr_t>(p) % alignof(double) == 0);
+        BOOST_CHECK(arena.used() >= 100 * sizeof(double));
+        arena.reset(mark);
+        BOOST_CHECK(arena.used() == 0);
+        BOOST_CHECK(arena.allocate<double>(100) == p);
+    }
+    BOOST_CHECK(arena.heap_allocations() == 1);
+
+    //temporaries of det, transpose and slices come from thread arena, which stops growing
+    auto m = matrix_view::make_random_matrix<double>(6, 6, -5, 5, 50);
+    auto r = matrix_view::make_random_matrix<double>(40, 30, -5, 5, 51);
+    auto run = [&]{
+        double d = m.det();
+        auto t = r;
+        t.transpose();
+        auto slice = r("2:10,3:end");
+        return std::make_pair(d, t(29, 39) == r(39, 29) && slice(0, 0) == r(2, 3));
+    };
+    auto first = run();
+    auto &local = matrix_view::scratch_arena();
+    size_t allocations = local.heap_allocations();
+    for(int k = 0; k < 10; ++k){
+        auto next = run();
+        BOOST_CHECK(next.first == first.first && next.second);
+    }
+    BOOST_CHECK(local.heap_allocations() == allocations);
+    BOOST_CHECK(local.used() == 0);
+    BOOST_CHECK(std::fabs(first.first - std::lround(first.first)) < 1e-6);
+
+    //exact det and rank of integer matrix keep elimination buffers in the arena too
+    auto integer = matrix_view::make_random_matrix<long>(6, 6, -5, 5, 52);
+    long det = integer.det();
+    size_t rank = integer.rank();
+    size_t heap = heap_allocations;
+    bool same = true;
+    for(int k = 0; k < 10; ++k)
+        same = same && integer.det() == det && integer.rank() == rank;
+    BOOST_CHECK(heap_allocations == heap);
+    BOOST_CHECK(same && local.used() == 0);
+    heap = heap_allocations;
+    for(int k = 0; k < 10; ++k)
+        same = same && m.det() == first.first;
+    BOOST_CHECK(heap_allocations == heap && same);
+
+    //caller workspace
+    std::vector<char> buffer(1 << 16);
+    matrix_view::ScratchArena workspace(buffer.data(), buffer.size());
+    {
+        matrix_view::WorkspaceScope scope(workspace);
+        BOOST_CHECK(&matrix_view::scratch_arena() == &workspace);
+        BOOST_CHECK(m.det() == first.first);
+    }
+    BOOST_CHECK(&matrix_view::scratch_arena() == &local);
+    BOOST_CHECK(workspace.heap_allocations() == 0 && workspace.used() == 0);
+
+    auto c = matrix_view::cat(2, r("0:4,0:2"), r("0:4,5:7"));
+    BOOST_CHECK(c.rows() == 4 && c.columns() == 4 && c(3, 2) == r(3, 5));
+    auto v = matrix_view::cat(1, r("0:2,:"), r);
+    BOOST_CHECK(v.rows() == 42 && v(2, 0) == r(0, 0));
+}
+
+BOOST_AUTO_TEST_CASE(check_external_matrix)
+{
+    //4 x 3 matrix in buffer with rows of 5 elements
+    std::vector<double> buffer(20);
+    for(size_t k = 0; k < buffer.size(); ++k)
+        buffer[k] = double(k);
+    matrix_view::ExternalMatrix<double> e(buffer.data(), 4, 3, 5);
+    BOOST_CHECK(e(2, 1) == 11 && !e.contiguous());
+    BOOST_CHECK(e.extent(0) == 4 && e.extent(1) == 3 && e.stride(0) == 5 && e.stride(1) == 1);
+    e(0, 0) = -1;
+    BOOST_CHECK(buffer[0] == -1);
+    BOOST_CHECK_THROW(e(4, 0), std::out_of_range);
+
+    auto dense = e.to_matrix();
+    BOOST_CHECK(dense.rows() == 4 && dense.columns() == 3 && dense(3, 2) == 17);
+    auto b = matrix_view::make_random_matrix<double>(3, 6, -5, 5, 60);
+    BOOST_CHECK(e.dot(b) == dense.dot(b));
+    matrix_view::ExternalMatrix<const double> cb(b);
+    BOOST_CHECK(matrix_view::dot(e, cb) == dense.dot(b));
+    auto sub = e.block(1, 1, 2, 2);
+    BOOST_CHECK(sub(0, 0) == 6 && sub(1, 1) == 12);
+    BOOST_CHECK(matrix_view::dot(dense, matrix_view::ExternalMatrix<double>(buffer.data(), 3, 2, 5)) ==
+                dense.dot(matrix_view::ExternalMatrix<double>(buffer.data(), 3, 2, 5).to_matrix()));
+    BOOST_CHECK_THROW(e.dot(dense), std::length_error);
+
+    //ownership is transferred with deleter, copies share it
+    int deleted = 0;
+    {
+        auto owned = new long[6]{1, 2, 3, 4, 5, 6};
+        matrix_view::ExternalMatrix<long> o(owned, 2, 3, 3, [&deleted](long *q){ delete[] q; ++deleted; });
+        auto copy = o.block(1, 0, 1, 3);
+        {
+            auto o2 = o;
+        }
+        BOOST_CHECK(deleted == 0 && copy(0, 2) == 6);
+    }
+    BOOST_CHECK(deleted == 1);
+
+    //owned buffer is freed, if its shape is wrong
+    auto wrong = new long[6]();
+    BOOST_CHECK_THROW(matrix_view::ExternalMatrix<long>(wrong, 2, 3, 2, [&deleted](long *q){ delete[] q; ++deleted; }),
+                      std::logic_error);
+    BOOST_CHECK(deleted == 2);
+}
+
+BOOST_AUTO_TEST_CASE(check_append_and_reshape)
+{
+    matrix_view::Matrix<int> m;
+    m.reserve(4, 3);
+    BOOST_CHECK(m.rows() == 0 && m.columns() == 3 && m.capacity() == 4);
+    m.append_row({1, 2, 3});
+    BOOST_CHECK(m.rows() == 1 && m.columns() == 3 && m.capacity() >= 4);
+    const int* storage = m.data();
+    std::vector<int> row{4, 5, 6};
+    m.append_row(row);
+    int raw[] = {7, 8, 9};
+    m.append_row(raw, 3);
+    BOOST_CHECK(m.data() == storage);
+    m.append_rows(matrix_view::Matrix<int>{{10, 11, 12}, {13, 14, 15}});
+    BOOST_CHECK(m.rows() == 5 && m(4, 2) == 15 && m(1, 0) == 4);
+    BOOST_CHECK_THROW(m.append_row({1, 2}), std::runtime_error);
+
+    //rows of the matrix itself are copied before storage grows
+    matrix_view::Matrix<int> self{{1, 2}, {3, 4}};
+    self.shrink_to_fit();
+    self.append_row(self.data(), self.columns());
+    self.shrink_to_fit();
+    self.append_row(self("1:2,:"));
+    self.shrink_to_fit();
+    self.append_rows(self);
+    BOOST_CHECK(self == (matrix_view::Matrix<int>{{1, 2}, {3, 4}, {1, 2}, {3, 4}, {1, 2}, {3, 4}, {1, 2}, {3, 4}}));
+
+    //geometric growth: few reallocations for many rows
+    size_t reallocations = 0;
+    const int* last = m.data();
+    for(int i = 0; i < 1000; ++i){
+        m.append_row({i, i, i});
+        if(m.data() != last){
+            ++reallocations;
+            last = m.data();
+        }
+    }
+    BOOST_CHECK(m.rows() == 1005 && reallocations < 12);
+
+    m.shrink_to_fit();
+    BOOST_CHECK(m.capacity() == m.rows());
+    const int* before = m.data();
+    m.reshape(335, 9);
+    BOOST_CHECK(m.data() == before && m.rows() == 335 && m.columns() == 9 && m(0, 4) == 5);
+    BOOST_CHECK_THROW(m.reshape(10, 10), std::runtime_error);
+    BOOST_CHECK_THROW(m.reserve(10, 4), std::runtime_error);
+
+    //empty matrix remembers reserved columns
+    matrix_view::Matrix<double> empty;
+    empty.reserve(100, 4);
+    BOOST_CHECK(empty.capacity() == 100);
+    const double* reserved = empty.data();
+    for(int i = 0; i < 100; ++i)
+        empty.append_row({0.5, 1.5, 2.5, 3.5});
+    BOOST_CHECK(empty.data() == reserved && empty.rows() == 100);
+}
+
+BOOST_AUTO_TEST_CASE(check_autotune)
+{
+    auto defaults = matrix_view::current_profile();
+    auto path = (std::filesystem::temp_directory_path() / "matrix_view_profile_test.txt").string();
+    std::filesystem::remove(path);
+
+    //another CPU keeps its line
+    auto other = defaults;
+    other.transposeTile = 7;
+    matrix_view::save_profile(path, other, "other cpu");
+
+    matrix_view::TuneOptions options;
+    options.size = 64;
+    options.repeats = 1;
+    BOOST_CHECK(!matrix_view::autotune(path, options));
+    auto tuned = matrix_view::current_profile();
+    BOOST_CHECK(tuned.gemm.blockRows >= 16 && tuned.gemm.blockRows <= 128);
+    BOOST_CHECK(tuned.transposeTile >= 8 && tuned.transposeTile <= 128);
+    BOOST_CHECK(tuned.gemm.strassenCrossover >= 32);
+
+    matrix_view::apply_profile(defaults);
+    BOOST_CHECK(matrix_view::autotune(path, options));
+    auto loaded = matrix_view::current_profile();
+    BOOST_CHECK(loaded.gemm.blockInner == tuned.gemm.blockInner && loaded.transposeTile == tuned.transposeTile &&
+                loaded.parallelThreshold == tuned.parallelThreshold);
+    matrix_view::TuneProfile p;
+    BOOST_CHECK(matrix_view::load_profile(path, p, "other cpu") && p.transposeTile == 7);
+    BOOST_CHECK(!matrix_view::load_profile(path, p, "missing"));
+
+    //zero or absurd values are rejected and the profile is tuned again
+    for(std::string bad: {"0 128 256 512 32 1024", "64 128 256 0 32 1024", "64 128 256 512 100000 1024",
+                          "64 128 256 512 32 0"}){
+        {
+            std::ofstream out(path, std::ios::trunc);
+            out << matrix_view::cpu_key() << '\t' << bad << '\n';
+        }
+        BOOST_CHECK(!matrix_view::load_profile(path, p));
+    }
+    BOOST_CHECK(!matrix_view::autotune(path, options));
+    BOOST_CHECK(matrix_view::current_profile().gemm.blockRows > 0 && matrix_view::load_profile(path, p));
+
+    //tuned kernels give the same results
+    auto a = matrix_view::make_random_matrix<long>(37, 53, -9, 9, 70);
+    auto b = matrix_view::make_random_matrix<long>(53, 29, -9, 9, 71);
+    auto expected = a.dot(b);
+    auto t = a;
+    t.transpose();
+    matrix_view::apply_profile(defaults);
+    BOOST_CHECK(a.dot(b) == expected);
+    auto t2 = a;
+    t2.transpose();
+    BOOST_CHECK(t == t2 && t(52, 36) == a(36, 52));
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(check_gram_and_covariance)
+{
+    auto x = matrix_view::make_random_matrix<long>(300, 70, -9, 9, 80);
+    auto xt = x;
+    xt.transpose();
+    BOOST_CHECK(matrix_view::gram(x) == xt.dot(x));
+    BOOST_CHECK(matrix_view::gram(x("0:5,2:6")) == matrix_view::gram(matrix_view::Matrix<long>(x("0:5,2:6"))));
+
+    //large offset does not spoil centered result
+    matrix_view::Matrix<double> d{{1e9 + 1, 2, 0}, {1e9 + 2, 4, 1}, {1e9 + 3, 6, 0}, {1e9 + 6, 12, 1}};
+    auto cov = matrix_view::covariance(d);
+    BOOST_CHECK(cov.rows() == 3 && cov.columns() == 3);
+    BOOST_CHECK(std::fabs(cov(0, 0) - 14.0 / 3) < 1e-9);
+    BOOST_CHECK(std::fabs(cov(1, 1) - 56.0 / 3) < 1e-9);
+    BOOST_CHECK(std::fabs(cov(0, 1) - 28.0 / 3) < 1e-9 && cov(0, 1) == cov(1, 0));
+    BOOST_CHECK(std::fabs(cov(2, 2) - 1.0 / 3) < 1e-12);
+    auto population = matrix_view::covariance(d, 0);
+    BOOST_CHECK(std::fabs(population(0, 0) - 3.5) < 1e-9);
+
+    auto corr = matrix_view::correlation(d);
+    BOOST_CHECK(corr(0, 0) == 1.0 && std::fabs(corr(0, 1) - 1.0) < 1e-12);
+    BOOST_CHECK(std::fabs(corr(1, 2) - corr(2, 1)) < 1e-15 && std::fabs(corr(0, 2)) < 1);
+
+    //many rows split between threads agree with centered product
+    auto y = matrix_view::make_random_matrix<double>(5000, 12, -5, 5, 81);
+    auto means = matrix_view::mean(y, 0);
+    matrix_view::Matrix<double> centered = y - means;
+    auto ct = centered;
+    ct.transpose();
+    auto expected = ct.dot(centered) / 4999.0;
+    matrix_view::set_threads(4);
+    BOOST_CHECK(matrix_view::allclose(matrix_view::covariance(y), expected, 1e-9, 1e-9));
+    //tiles of triangle split between threads
+    auto wide = matrix_view::make_random_matrix<long>(150, 200, -9, 9, 82);
+    auto wt = wide;
+    wt.transpose();
+    matrix_view::set_threads(3);
+    BOOST_CHECK(matrix_view::gram(wide) == wt.dot(wide));
+    matrix_view::set_threads(0);
+
+    BOOST_CHECK_THROW(matrix_view::covariance(matrix_view::Matrix<double>(1, 3)), std::length_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file